@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// atomic.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_ATOMIC_HPP
+#define BOOST_CONST_STRING_ATOMIC_HPP
+
+#include "boost/config.hpp"
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_HDR_MUTEX) && !defined(BOOST_NO_CXX11_HDR_THREAD)
+
+#include <atomic>
+#include <mutex>
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/detail/epoch.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A string value that threads load and replace concurrently, e.g. a setting reloaded
+// at run time that many threads read.
+//
+// load() takes no lock: it registers the reader in the counter of its thread for the current
+// epoch, copies the string and leaves. The counters are spread over 16 cache lines, so that
+// readers on different cores rarely write the same one. A writer installs the new string,
+// moves on to the next epoch and waits for the readers of the previous one before it destroys
+// the old string, so that the readers never wait for writers and writers are never starved
+// by new readers.
+// The writers take a mutex, so that store() and exchange() are not lock-free and suit
+// values replaced far less often than they are read.
+//
+//     atomic_const_string<> log_level(lit("info"));
+//     const_string<char> const level(log_level.load()); // on any thread
+
+template<class StringT = const_string<char> >
+class atomic_const_string
+{
+public:
+    typedef StringT value_type;
+
+public:
+    atomic_const_string() // throw(std::bad_alloc)
+        : current_(new StringT)
+    {}
+
+    explicit atomic_const_string(StringT const& s) // throw(std::bad_alloc)
+        : current_(new StringT(s))
+    {}
+
+    ~atomic_const_string()
+    {
+        delete current_.load();
+    }
+
+public:
+    StringT load() const // throw() when copying StringT doesn't throw
+    {
+        typename epoch::reader const r(readers_);
+        return *current_.load();
+    }
+
+    operator StringT() const // throw() when copying StringT doesn't throw
+    {
+        return this->load();
+    }
+
+    void store(StringT const& s) // throw(std::bad_alloc)
+    {
+        this->exchange(s);
+    }
+
+    atomic_const_string& operator=(StringT const& s) // throw(std::bad_alloc)
+    {
+        this->store(s);
+        return *this;
+    }
+
+    StringT exchange(StringT const& s) // throw(std::bad_alloc)
+    {
+        StringT* const p(new StringT(s));
+        std::lock_guard<std::mutex> lock(writer_);
+        return this->replace(p);
+    }
+
+    // replaces the string when it equals expected, otherwise loads it into expected
+    bool compare_exchange(StringT& expected, StringT const& desired) // throw(std::bad_alloc)
+    {
+        std::lock_guard<std::mutex> lock(writer_);
+        StringT const* const p(current_.load());
+        if(!(*p == expected))
+        {
+            expected = *p;
+            return false;
+        }
+        this->replace(new StringT(desired));
+        return true;
+    }
+
+    bool compare_exchange_strong(StringT& expected, StringT const& desired) // throw(std::bad_alloc)
+    {
+        return this->compare_exchange(expected, desired);
+    }
+
+    bool compare_exchange_weak(StringT& expected, StringT const& desired) // throw(std::bad_alloc)
+    {
+        return this->compare_exchange(expected, desired);
+    }
+
+private:
+    typedef cs::aux::epoch<16> epoch;
+
+    // the writer lock is held. A reader that got the old string registered in the current epoch
+    // or an earlier one, whose writer waited for it before this one started
+    StringT replace(StringT* p) // throw()
+    {
+        StringT* const old(current_.exchange(p));
+        readers_.synchronize();
+        StringT const s(*old);
+        delete old;
+        return s;
+    }
+
+private:
+    atomic_const_string(atomic_const_string const&);
+    atomic_const_string& operator=(atomic_const_string const&);
+
+private:
+    epoch readers_; // first, so that current_ isn't leaked when it throws
+    std::atomic<StringT*> current_;
+    std::mutex writer_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_NO_CXX11_HDR_ATOMIC
+
+#endif // BOOST_CONST_STRING_ATOMIC_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,345 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// compact_storage.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_COMPACT_STORAGE_HPP
+#define BOOST_CONST_STRING_COMPACT_STORAGE_HPP
+
+#include <cstring>
+#include <limits>
+#include <new>
+#include <memory>
+#include <stdexcept>
+
+#include "boost/config.hpp"
+#include "boost/static_assert.hpp"
+#include "boost/predef/other/endian.h"
+#include "boost/detail/atomic_count.hpp"
+#include "boost/type_traits/integral_constant.hpp"
+#include "boost/type_traits/is_empty.hpp"
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/relocatable.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+// the header of a shared block of const_string_compact_storage<>, the characters follow it
+struct compact_header
+{
+    boost::detail::atomic_count counter;
+    size_t size;
+
+    explicit compact_header(size_t n)
+        : counter(1)
+        , size(n)
+    {}
+};
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A storage strategy of the size of one pointer, for large arrays and hash table slots of strings.
+//
+// logic:
+//     if the source string size including trailing zero is no greater than sizeof(char*) - 1
+//         then it is stored inside the string next to a tag byte holding the size
+//     else
+//         it allocates and shares reference counted copy of the string,
+//         the size is stored in the shared block
+//
+// The low bit of the word tells the two apart: blocks are aligned, so that the bit
+// of a pointer to a block is always 0. The next bit marks an immortal block.
+//
+// There is no room for the size of a referenced string, so that boost::cref() makes copies
+// too. Reading the size of a long string touches the shared block. Only characters of one byte
+// are supported, as the inline characters start at an odd address.
+
+template<
+      class TraitsT
+    , class AllocatorT = std::allocator<typename TraitsT::char_type>
+    >
+class const_string_compact_storage
+    : private AllocatorT::template rebind<
+          typename cs::aux::aligned_union<cs::aux::compact_header, typename TraitsT::char_type>::type
+      >::other
+{
+private:
+    typedef TraitsT traits_type;
+    typedef typename TraitsT::char_type char_type;
+    typedef cs::aux::compact_header header;
+    typedef typename AllocatorT::template rebind<
+        typename cs::aux::aligned_union<header, typename TraitsT::char_type>::type
+    >::other allocator;
+
+    BOOST_STATIC_ASSERT(sizeof(char_type) == 1);
+    BOOST_STATIC_ASSERT(boost::alignment_of<header>::value >= 4);
+
+    enum { word_size = sizeof(char_type const*) };
+#if BOOST_ENDIAN_BIG_BYTE
+    enum { tag_index = word_size - 1, chars_index = 0 };
+#else
+    enum { tag_index = 0, chars_index = 1 };
+#endif
+
+    static unsigned char const inline_bit_mask = 1;
+    static unsigned char const immortal_bit_mask = 2;
+
+public:
+    enum { effective_buffer_size_chars = word_size - 1 };
+
+public:
+    const_string_compact_storage(char_type const* begin, size_t length, int /*reference_semantics*/)
+    {
+        this->init(begin, length);
+    }
+
+    const_string_compact_storage(char_type const* begin, size_t length)
+    {
+        this->init(begin, length);
+    }
+
+    const_string_compact_storage(const_string_compact_storage const& other) // throw()
+        : allocator(other)
+    {
+        std::memcpy(bytes_, other.bytes_, word_size);
+        if(this->is_counted())
+            ++this->block()->counter;
+    }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+    const_string_compact_storage(const_string_compact_storage&& other) BOOST_NOEXCEPT
+        : allocator(other)
+    {
+        this->set_inline(0);
+        this->swap(other);
+    }
+
+#endif // BOOST_NO_CXX11_RVALUE_REFERENCES
+
+    const_string_compact_storage const& operator=(const_string_compact_storage const& other) // throw()
+    {
+        if(this != &other)
+        {
+            this->allocator::operator=(other);
+            this->reset();
+            new (this) const_string_compact_storage(other);
+        }
+        return *this;
+    }
+
+    ~const_string_compact_storage()
+    {
+        this->reset();
+    }
+
+public:
+    void swap(const_string_compact_storage& other) // throw()
+    {
+        this->swap(other, boost::is_empty<allocator>());
+    }
+
+private:
+    void swap(const_string_compact_storage& other, boost::true_type) // throw()
+    {
+        unsigned char t[word_size];
+        std::memcpy(t, bytes_, word_size);
+        std::memcpy(bytes_, other.bytes_, word_size);
+        std::memcpy(other.bytes_, t, word_size);
+    }
+
+    void swap(const_string_compact_storage& other, boost::false_type) // throw()
+    {
+        const_string_compact_storage const t(*this);
+        *this = other;
+        other = t;
+    }
+
+public:
+    // a shared block is freed with the size it was allocated for, so that when the new size
+    // needs fewer elements the characters are moved to a block of the new size, or inside
+    const_string_compact_storage& set_size(size_t length) // throw(std::bad_alloc, std::length_error)
+    {
+        if(length > this->size())
+            throw std::length_error("const_string: the source string is way too long");
+        if(this->is_inline())
+            this->set_inline(length);
+        else if(!this->is_counted() || this->elements(length) == this->elements(this->size()))
+            this->block()->size = length;
+        else
+        {
+            const_string_compact_storage copy(this->begin(), length);
+            this->swap(copy);
+        }
+        return *this;
+    }
+
+    void seal() // throw()
+    {}
+
+    void make_immortal() // throw()
+    {
+        if(this->is_counted())
+        {
+            ++this->block()->counter;
+            bytes_[tag_index] |= immortal_bit_mask;
+        }
+    }
+
+public:
+    size_t max_size() const
+    {
+        return (std::numeric_limits<size_t>::max() - sizeof(header)) / sizeof(char_type) - 1;
+    }
+
+    size_t size() const
+    {
+        return this->is_inline()
+            ? bytes_[tag_index] >> 1
+            : this->block()->size
+            ;
+    }
+
+    char_type const* begin() const
+    {
+        return this->is_inline()
+            ? reinterpret_cast<char_type const*>(bytes_ + chars_index)
+            : reinterpret_cast<char_type const*>(reinterpret_cast<typename allocator::pointer>(this->block()) + 1)
+            ;
+    }
+
+    char_type const* end() const
+    {
+        return this->begin() + this->size();
+    }
+
+    int compare(const_string_compact_storage const& other) const // throw()
+    {
+        return cs::aux::compare_chars<traits_type>(this->begin(), this->size(), other.begin(), other.size());
+    }
+
+    bool is_terminated() const // throw(), the characters are always copied
+    {
+        return true;
+    }
+
+    bool is_reference() const // throw()
+    {
+        return false;
+    }
+
+private:
+    void init(char_type const* begin, size_t length)
+    {
+        if(length > this->max_size())
+            throw std::length_error("const_string: the source string is way too long");
+
+        char_type* copy;
+
+        if(length < effective_buffer_size_chars)
+        {
+            this->set_inline(length);
+            copy = reinterpret_cast<char_type*>(bytes_ + chars_index);
+        }
+        else
+        {
+            void* const p(this->allocator::allocate(this->elements(length)));
+            header* const h(new (p) header(length));
+            std::memcpy(bytes_, &h, word_size);
+            copy = const_cast<char_type*>(this->begin());
+        }
+
+        if(begin)
+            TraitsT::copy(copy, begin, length);
+
+        copy[length] = char_type();
+    }
+
+    void reset()
+    {
+        if(this->is_counted() && 0 == --this->block()->counter)
+        {
+            header* const h(this->block());
+            size_t const n(this->elements(h->size));
+            h->~header();
+            this->allocator::deallocate(reinterpret_cast<typename allocator::pointer>(h), n);
+        }
+        this->set_inline(0);
+    }
+
+    static size_t elements(size_t length)
+    {
+        size_t const character_bytes((length + 1) * sizeof(char_type));
+        return 1
+            + character_bytes / sizeof(typename allocator::value_type)
+            + (0 != character_bytes % sizeof(typename allocator::value_type))
+            ;
+    }
+
+    void set_inline(size_t length)
+    {
+        bytes_[tag_index] = static_cast<unsigned char>(length << 1 | inline_bit_mask);
+    }
+
+    bool is_inline() const
+    {
+        return 0 != (bytes_[tag_index] & inline_bit_mask);
+    }
+
+    bool is_counted() const
+    {
+        return 0 == (bytes_[tag_index] & (inline_bit_mask | immortal_bit_mask));
+    }
+
+    header* block() const
+    {
+        header* h;
+        std::memcpy(&h, bytes_, word_size);
+        return reinterpret_cast<header*>(reinterpret_cast<size_t>(h) & ~size_t(immortal_bit_mask));
+    }
+
+private:
+    unsigned char bytes_[word_size];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class CharT, class TraitsT = std::char_traits<CharT> >
+struct compact_const_string
+{
+    typedef const_string<CharT, TraitsT, const_string_compact_storage<TraitsT> > type;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+
+template<class TraitsT, class AllocatorT>
+struct is_trivially_relocatable<const_string_compact_storage<TraitsT, AllocatorT> >
+    : boost::is_empty<AllocatorT>
+{};
+
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_COMPACT_STORAGE_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
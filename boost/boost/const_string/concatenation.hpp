@@ -43,6 +43,11 @@ public:
     size_t size() const { return static_cast<size_t>(-1) == size_ ? size_ = left_.size() + right_.size() : size_; }
     void copy_result_to(typename StringT::char_type*) const;
 
+    // calls f(piece) for the strings concatenated left to right, no characters are copied,
+    // the pieces that were not const_strings refer to the arguments
+    template<class F>
+    void for_each_piece(F& f) const;
+
 private:
     LeftT const left_;
     RightT const right_;
@@ -257,6 +262,38 @@ void copy_result_to(
     from.copy_result_to(to);
 }
 
+template<
+      class char_type
+    , class traits_type
+    , class S
+    , class F
+    >
+inline
+void for_each_piece(
+      boost::const_string<char_type, traits_type, S> const& from
+    , F& f
+    )
+{
+    f(from);
+}
+
+template<
+      class char_type
+    , class traits_type
+    , class storage_t
+    , class V1
+    , class V2
+    , class F
+    >
+inline
+void for_each_piece(
+      boost::concatenation<boost::const_string<char_type, traits_type, storage_t>, V1, V2> const& from
+    , F& f
+    )
+{
+    from.for_each_piece(f);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
 }}} // namespace boost { namespace cs { namespace aux {
@@ -271,6 +308,15 @@ void boost::concatenation<StringT, LeftT, RightT>::copy_result_to(typename Strin
     cs::aux::copy_result_to(to + left_.size(), right_);
 }
 
+template<class StringT, class LeftT, class RightT>
+template<class F>
+inline
+void boost::concatenation<StringT, LeftT, RightT>::for_each_piece(F& f) const
+{
+    cs::aux::for_each_piece(left_, f);
+    cs::aux::for_each_piece(right_, f);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
 #ifdef BOOST_MSVC
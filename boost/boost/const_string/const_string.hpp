@@ -15,8 +15,14 @@
 #include <string>
 #include <stdexcept>
 
+#include "boost/config.hpp"
 #include "boost/ref.hpp"
 #include "boost/type_traits/is_pod.hpp"
+#include "boost/utility/result_of.hpp"
+
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+#   include <string_view>
+#endif
 
 #include "boost/const_string/const_string_fwd.hpp"
 #include "boost/const_string/detail/storage.hpp"
@@ -30,16 +36,6 @@ namespace boost {
 namespace cs {
 namespace aux {
 
-////////////////////////////////////////////////////////////////////////////////////////////////
-
-template<class char_type>
-struct zero_string_literal
-{
-    static char_type const value[1];
-};
-
-template<class char_type>
-char_type const zero_string_literal<char_type>::value[1] = { 0 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -64,6 +60,67 @@ typename T::size_type checked_size(T const& t, typename T::size_type pos, typena
         return std::min(n, size - pos);
 }
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+// the owner of a std::basic_string<> moved into a string
+template<class StringT>
+struct adopted_string : external_owner
+{
+    StringT str;
+    external_slice<typename StringT::value_type> slice;
+
+    explicit adopted_string(StringT&& s) // throw()
+        : external_owner(&adopted_string::destroy)
+        , str(static_cast<StringT&&>(s))
+    {
+        slice.owner = this;
+        slice.data = str.data();
+        slice.size = str.size();
+    }
+
+    static void destroy(external_owner* o) // throw()
+    {
+        delete static_cast<adopted_string*>(o);
+    }
+};
+
+// a moved std::basic_string<> of fewer bytes is copied, so is one with more than
+// twice the capacity it needs, to not keep the slack alive
+enum { adopt_string_min_bytes = 256 };
+
+template<class StorageT, class StringT>
+inline StorageT adopt_string(StringT& s, boost::true_type) // throw(std::bad_alloc, std::length_error)
+{
+    size_t const size(s.size());
+    if(size < StorageT::effective_buffer_size_chars
+        || size * sizeof(typename StringT::value_type) < adopt_string_min_bytes
+        || s.capacity() / 2 > size
+        )
+        return StorageT(s.data(), size);
+
+    adopted_string<StringT>* const owner(new adopted_string<StringT>(static_cast<StringT&&>(s)));
+    try
+    {
+        StorageT stg(owner->slice);
+        cs::aux::release(owner); // the string holds the owner from now on
+        return stg;
+    }
+    catch(...)
+    {
+        s = static_cast<StringT&&>(owner->str); // give the characters back
+        delete owner;
+        throw;
+    }
+}
+
+template<class StorageT, class StringT>
+inline StorageT adopt_string(StringT& s, boost::false_type) // throw(std::bad_alloc, std::length_error)
+{
+    return StorageT(s.data(), s.size());
+}
+
+#endif // BOOST_NO_CXX11_RVALUE_REFERENCES
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
 } // namespace aux {
@@ -80,7 +137,16 @@ class const_string : private StorageT
 {
 private:
     BOOST_STATIC_ASSERT(boost::is_pod<CharT>::value);
-    enum { reference_semantics };
+    enum { reference_semantics, terminated_reference_semantics };
+
+    // the reference semantics for the characters of a source from pos on, n at most
+    static int reference_to(bool source_terminated, size_t size, size_t pos, size_t n) // throw()
+    {
+        return source_terminated && pos <= size && n >= size - pos
+            ? terminated_reference_semantics
+            : reference_semantics
+            ;
+    }
 
 public:
     typedef StorageT storage_type;
@@ -101,13 +167,16 @@ public:
     static size_t const npos = static_cast<size_t>(-1);
 
     typedef std::basic_string<char_type, traits_type> std_string_type;
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+    typedef std::basic_string_view<char_type, traits_type> std_string_view_type;
+#endif
 
 public:
     const_string() // throw(std::bad_alloc) only in case when sizeof(char_type) > sizeof(char_type*) and buffer_size is 0
         : storage_type(
               boost::cs::aux::zero_string_literal<char_type>::value
             , 0
-            , reference_semantics
+            , terminated_reference_semantics
             )
     {}
 
@@ -116,6 +185,10 @@ public:
     {}
 
 public: // const_string arg
+    const_string(const_string const& str) // throw()
+        : storage_type(str)
+    {}
+
     const_string(const_string const& str, size_t pos, size_t n = npos) // throw(std::bad_alloc, std::out_of_range, std::length_error)
         : storage_type(
               cs::aux::checked_data(str, pos)
@@ -123,6 +196,12 @@ public: // const_string arg
             )
     {}
 
+    // a copy of a string with another storage
+    template<class S>
+    explicit const_string(const_string<char_type, traits_type, S> const& str) // throw(std::bad_alloc, std::length_error)
+        : storage_type(str.data(), str.size())
+    {}
+
     const_string(boost::reference_wrapper<const_string const> const& str) // throw()
         : storage_type(str.get())
     {}
@@ -131,7 +210,7 @@ public: // const_string arg
         : storage_type(
               cs::aux::checked_data(str.get(), pos)
             , cs::aux::checked_size(str.get(), pos, n)
-            , reference_semantics
+            , reference_to(str.get().storage_type::is_terminated(), str.get().size(), pos, n)
             )
     {}
 
@@ -141,6 +220,20 @@ public: // const_string arg
 		return *this;
 	}
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+    const_string(const_string&& str) BOOST_NOEXCEPT
+        : storage_type(static_cast<storage_type&&>(str))
+    {}
+
+    const_string& operator=(const_string&& str) BOOST_NOEXCEPT
+    {
+        this->swap(str);
+        return *this;
+    }
+
+#endif // BOOST_NO_CXX11_RVALUE_REFERENCES
+
 	const_string& operator=(boost::reference_wrapper<const_string const> const& str) // throw()
     {
 		this->storage_type::operator=(str.get());
@@ -156,6 +249,34 @@ public: // std::basic_string<> arg
     {}
 
     const_string(boost::reference_wrapper<std_string_type const> const& str, size_t pos = 0, size_t n = npos) // throw(std::out_of_range, std::length_error)
+        : storage_type(
+              cs::aux::checked_data(str.get(), pos)
+            , cs::aux::checked_size(str.get(), pos, n)
+            , reference_to(true, str.get().size(), pos, n) // data() is c_str()
+            )
+    {}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+    // takes over the buffer of a long string rather than copying the characters,
+    // short strings and strings with much unused capacity are copied
+    const_string(std_string_type&& str) // throw(std::bad_alloc, std::length_error)
+        : storage_type(cs::aux::adopt_string<storage_type>(str, cs::aux::can_refer_external<storage_type>()))
+    {}
+
+#endif // BOOST_NO_CXX11_RVALUE_REFERENCES
+
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+
+public: // std::basic_string_view<> arg
+    const_string(std_string_view_type const& str, size_t pos = 0, size_t n = npos) // throw(std::bad_alloc, std::out_of_range, std::length_error)
+        : storage_type(
+              cs::aux::checked_data(str, pos)
+            , cs::aux::checked_size(str, pos, n)
+            )
+    {}
+
+    const_string(boost::reference_wrapper<std_string_view_type const> const& str, size_t pos = 0, size_t n = npos) // throw(std::out_of_range, std::length_error)
         : storage_type(
               cs::aux::checked_data(str.get(), pos)
             , cs::aux::checked_size(str.get(), pos, n)
@@ -163,6 +284,8 @@ public: // std::basic_string<> arg
             )
     {}
 
+#endif // BOOST_NO_CXX17_HDR_STRING_VIEW
+
 public: // char_type* arg
     const_string(char_type const* s, size_t n = npos) // throw(std::bad_alloc, std::length_error)
         : storage_type(
@@ -175,7 +298,7 @@ public: // char_type* arg
         : storage_type(
               s.get()
             , npos == n ? traits_type::length(s.get()) : n
-            , reference_semantics
+            , npos == n ? terminated_reference_semantics : reference_semantics
         )
     {}
 
@@ -183,7 +306,7 @@ public: // char_type* arg
         : storage_type(
               s.get()
             , npos == n ? traits_type::length(s.get()) : n
-            , reference_semantics
+            , npos == n ? terminated_reference_semantics : reference_semantics
         )
     {}
 
@@ -216,7 +339,9 @@ public: // char_type[] arg
         : storage_type(
               s.get()
             , npos == n ? traits_type::length(s.get()) : n
-            , reference_semantics
+            , npos == n || (n < N && traits_type::eq(s.get()[n], char_type())) // lit() passes N - 1
+                ? terminated_reference_semantics
+                : reference_semantics
         )
     {}
 
@@ -226,12 +351,14 @@ public: // other
         : storage_type(0, std::distance(begin, end))
     {
         std::copy(begin, end, const_cast<char_type*>(this->data()));
+        this->storage_type::seal();
     }
 
     const_string(size_t n, char_type c) // throw(std::bad_alloc, std::length_error)
         : storage_type(0, n)
     {
         std::fill_n(const_cast<char_type*>(this->begin()), n, c);
+        this->storage_type::seal();
     }
 
     const_string& operator=(char_type c) // throw(std::bad_alloc)
@@ -246,6 +373,28 @@ public:
         : storage_type(0, expr.size())
     {
         expr.copy_result_to(const_cast<char_type*>(this->begin()));
+        this->storage_type::seal();
+    }
+
+public: // adopting a buffer
+    typedef typename cs::aux::adopted_buffer<char_type>::release_function release_function;
+
+    // refers to the characters of the buffer in place, with no copy, and calls
+    // release(context, data, size) when the last string referring to them is gone.
+    // The buffer must stay unchanged until then and needs no trailing zero, c_str() of such
+    // a string makes a copy, with_c_str() doesn't. When it throws the buffer is not adopted
+    // and release() is not called. Only const_string_storage<> supports it.
+    static const_string adopt(char_type const* data, size_t size, release_function release, void* context = 0) // throw(std::bad_alloc, std::length_error)
+    {
+        if(size > const_string().max_size())
+            throw std::length_error("const_string: the source string is way too long");
+
+        cs::aux::adopted_buffer<char_type>* const owner(
+            new cs::aux::adopted_buffer<char_type>(data, size, release, context)
+            );
+        const_string const s(storage_type(owner->slice));
+        cs::aux::release(owner); // the strings hold the owner from now on
+        return s;
     }
 
 public:
@@ -282,13 +431,36 @@ public:
 
     char_type const* c_str() const // throw(std::bad_alloc), always has the trailing zero
     {
-        // this condition yields true if this string was obtained via ref_substr()
-        // and thus may not have the trailing zero
-        if(char_type() != *this->end())
+        // a reference, e.g. obtained via ref_substr(), may not have the trailing zero,
+        // then the string replaces itself with a copy, which a string shared
+        // by threads must not do: use with_c_str() instead
+        if(!this->storage_type::is_terminated())
             const_cast<const_string&>(*this) = const_string(this->begin(), this->end());
         return this->begin();
     }
 
+    // returns f(s), s being the characters with the trailing zero, e.g. for a system call,
+    // without changing the string: the characters of a reference with no trailing zero
+    // are copied to a buffer on the stack or, when they don't fit, to a temporary string
+    template<class F>
+    typename boost::result_of<F(char_type const*)>::type with_c_str(F f) const // throw(std::bad_alloc, ...)
+    {
+        if(this->storage_type::is_terminated())
+            return f(this->begin());
+
+        enum { buffer_chars = 256 / sizeof(char_type) };
+        size_t const size(this->size());
+        if(size < buffer_chars)
+        {
+            char_type buffer[buffer_chars];
+            traits_type::copy(buffer, this->begin(), size);
+            buffer[size] = char_type();
+            return f(static_cast<char_type const*>(buffer));
+        }
+        const_string const copy(this->begin(), this->end());
+        return f(copy.begin());
+    }
+
     size_t copy(char_type* s, size_t n, size_t pos = 0) const
     {
         size_t const size(this->size());
@@ -307,6 +479,16 @@ public:
         return std_string_type(this->begin(), this->end());
     }
 
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+
+    // the view is valid as long as this string or any copy of it is
+    operator std_string_view_type() const // throw()
+    {
+        return std_string_view_type(this->data(), this->size());
+    }
+
+#endif // BOOST_NO_CXX17_HDR_STRING_VIEW
+
     const_string substr(size_t pos = 0, size_t n = npos) const // throw(std::bad_alloc, std::out_of_range)
     {
         return const_string(*this, pos, n);
@@ -317,6 +499,18 @@ public:
         return const_string(boost::cref(*this), pos, n);
     }
 
+    // whether the string refers to characters it doesn't keep alive, as the strings
+    // boost::cref() and ref_substr() make do, so that they must outlive the string
+    bool is_reference() const { return this->storage_type::is_reference(); } // throw()
+
+    // for strings that live till the end of the program, e.g. loaded configuration:
+    // a shared copy is never freed and its copies don't touch the reference counter
+    const_string& make_immortal() // throw()
+    {
+        this->storage_type::make_immortal();
+        return *this;
+    }
+
 public:
     void clear() // throw()
     {
@@ -325,9 +519,7 @@ public:
 
     void swap(const_string& other) // throw()
     {
-        const_string const t(*this);
-        *this = other;
-        other = t;
+        this->storage_type::swap(other);
     }
     
 public:
@@ -457,9 +649,20 @@ public: // find
         char_type const* this_data(this->data());
         char_type const* str_data(str.data());
 
+        if (!str_size)
+            return pos <= this_size ? pos : npos;
+
+        // the candidates are where the first character is, found with traits_type::find(),
+        // see const_string_searcher<> for a needle searched for many times
         for (; pos + str_size <= this_size; ++pos)
-            if (!traits_type::compare(this_data + pos, str_data, str_size))
+        {
+            char_type const* const p(traits_type::find(this_data + pos, this_size - str_size - pos + 1, str_data[0]));
+            if (!p)
+                break;
+            pos = p - this_data;
+            if (!traits_type::compare(p + 1, str_data + 1, str_size - 1))
                 return pos;
+        }
 
         return npos;
     }
@@ -576,7 +779,13 @@ public: // find
 
     size_t find(char_type s, size_t pos = 0) const // throw()
     {
-        return this->find(const_string(boost::cref(&s), 1), pos);
+        // traits_type::find() is memchr() for char
+        size_t const size(this->size());
+        if(pos >= size)
+            return npos;
+        char_type const* const data(this->data());
+        char_type const* const p(traits_type::find(data + pos, size - pos, s));
+        return p ? p - data : npos;
     }
 
     size_t rfind(char_type const* s, size_t pos, size_t n) const // throw(std::length_error)
@@ -591,7 +800,8 @@ public: // find
 
     size_t rfind(char_type s, size_t pos = 0) const // throw()
     {
-        return this->rfind(const_string(boost::cref(&s), 1), pos);
+        char_type const* const p(&s);
+        return this->rfind(const_string(boost::cref(p), 1), pos);
     }
 
     size_t find_first_of(const_string const& str, size_t pos = 0) const // throw()
@@ -645,13 +855,16 @@ public: // find
     }
 
 public: // compare
+    // the storage may decide it without looking at all the characters
+    int compare(const_string const& b) const // throw()
+    {
+        return this->storage_type::compare(b);
+    }
+
     template<class S>
     int compare(const_string<char_type, traits_type, S> const& b) const // throw()
     {
-        size_t const a_lenght(this->size());
-        size_t const b_lenght(b.size());
-        int const res(traits_type::compare(this->data(), b.data(), std::min(a_lenght, b_lenght)));
-        return res ? res : static_cast<int>(a_lenght - b_lenght);
+        return cs::aux::compare_chars<traits_type>(this->data(), this->size(), b.data(), b.size());
     }
 
     template<class S>
@@ -695,6 +908,13 @@ size_t const boost::const_string<T1, T2, T3>::npos;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
+template<class T1, class T2, class T3>
+inline void swap(const_string<T1, T2, T3>& a, const_string<T1, T2, T3>& b) // throw()
+{
+    a.swap(b);
+}
+////////////////////////////////////////////////////////////////////////////////////////////////
+
 template<class CharT, size_t N>
 inline const_string<CharT> lit(CharT const(&literal)[N]) // throw()
 {
@@ -714,8 +934,6 @@ bool operator op( \
     return a.compare(b) op 0; \
 }
 
-CONST_STRING_DEFINE_COMPARISON(==)
-CONST_STRING_DEFINE_COMPARISON(!=)
 CONST_STRING_DEFINE_COMPARISON(<)
 CONST_STRING_DEFINE_COMPARISON(<=)
 CONST_STRING_DEFINE_COMPARISON(>)
@@ -723,6 +941,25 @@ CONST_STRING_DEFINE_COMPARISON(>=)
 
 #undef CONST_STRING_DEFINE_COMPARISON
 
+// strings of different sizes are never equal, no character is looked at
+template<class char_type, class traits_type, class S1, class S2>
+inline bool operator==(
+      const_string<char_type, traits_type, S1> const& a
+    , const_string<char_type, traits_type, S2> const& b
+    )
+{
+    return a.size() == b.size() && 0 == a.compare(b);
+}
+
+template<class char_type, class traits_type, class S1, class S2>
+inline bool operator!=(
+      const_string<char_type, traits_type, S1> const& a
+    , const_string<char_type, traits_type, S2> const& b
+    )
+{
+    return !(a == b);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
 #define CONST_STRING_DEFINE_COMPARISONS \
@@ -765,6 +1002,14 @@ CONST_STRING_DEFINE_COMPARISONS
 #undef CONST_STRING_CMP_ARG
 #undef CONST_STRING_CMP_TMPL_AGRS
 
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+#define CONST_STRING_CMP_TMPL_AGRS 
+#define CONST_STRING_CMP_ARG std::basic_string_view<T1, T2> const&
+CONST_STRING_DEFINE_COMPARISONS
+#undef CONST_STRING_CMP_ARG
+#undef CONST_STRING_CMP_TMPL_AGRS
+#endif // BOOST_NO_CXX17_HDR_STRING_VIEW
+
 #undef CONST_STRING_DEFINE_COMPARISON_B
 #undef CONST_STRING_DEFINE_COMPARISON_A
 #undef CONST_STRING_DEFINE_COMPARISON
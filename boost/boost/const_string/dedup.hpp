@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// dedup.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_DEDUP_HPP
+#define BOOST_CONST_STRING_DEDUP_HPP
+
+#include <vector>
+#include <memory>
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/hash_map.hpp"
+#include "boost/const_string/detail/key.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Loads strings sharing the copies of the repeated ones.
+//
+// A string loaded before is returned as a copy of the first one, which shares its block,
+// so that a dataset with many repeated values keeps one block per distinct value.
+// Strings short enough to be stored inside a const_string are never kept.
+//
+// The memory the loader keeps is bounded by the budget given in bytes: the characters
+// of the kept strings, their slots in the hash table and in the eviction ring.
+// When it is exceeded the strings not loaded for the longest are forgotten,
+// approximately, as chosen by the CLOCK algorithm: a string is forgotten when the hand
+// sweeping the ring finds it not loaded since the previous sweep. A forgotten string
+// lives on in the strings returned.
+//
+// It is an ordinary object, one per dataset or loading thread, not a global intern table.
+
+template<
+      class StringT = const_string<char>
+    , class AllocatorT = std::allocator<StringT>
+    >
+class dedup_loader
+{
+public:
+    typedef StringT value_type;
+    typedef cs::aux::string_key<StringT> key;
+
+private:
+    typedef typename StringT::char_type char_type;
+
+    struct entry
+    {
+        StringT str;
+        bool used;
+        bool referenced;
+    };
+
+    typedef typename AllocatorT::template rebind<entry>::other entry_allocator;
+    typedef typename AllocatorT::template rebind<size_t>::other index_allocator;
+    typedef typename AllocatorT::template rebind<std::pair<StringT const, size_t> >::other map_allocator;
+    typedef const_string_map<size_t, StringT, map_allocator> map;
+
+public:
+    explicit dedup_loader(size_t budget) // throw()
+        : budget_(budget)
+        , memory_(0)
+        , hand_(0)
+        , hits_(0)
+        , misses_(0)
+    {}
+
+public:
+    size_t size() const { return map_.size(); } // throw()
+    size_t budget() const { return budget_; } // throw()
+    size_t memory() const { return memory_; } // throw()
+    size_t hits() const { return hits_; } // throw()
+    size_t misses() const { return misses_; } // throw()
+
+    // returns a copy of the string loaded before or of the key
+    value_type operator()(key const& k) // throw(std::bad_alloc, std::length_error)
+    {
+        if(k.size < StringT::storage_type::effective_buffer_size_chars)
+            return value_type(k.data, k.size);
+
+        typename map::iterator const i(map_.find(k));
+        if(i != map_.end())
+        {
+            ++hits_;
+            ring_[i->second].referenced = true;
+            return i->first;
+        }
+
+        ++misses_;
+        value_type const s(k.data, k.size);
+        size_t const cost(this->cost(s));
+        if(cost > budget_)
+            return s;
+        while(memory_ + cost > budget_)
+            this->evict();
+
+        if(free_.empty())
+        {
+            entry const e = { value_type(), false, false };
+            free_.reserve(ring_.size() + 1);
+            ring_.push_back(e);
+            free_.push_back(ring_.size() - 1);
+        }
+        size_t const index(free_.back());
+        map_.insert(std::make_pair(s, index));
+        free_.pop_back();
+
+        entry& e(ring_[index]);
+        e.str = s;
+        e.used = true;
+        e.referenced = false;
+        memory_ += cost;
+        return s;
+    }
+
+    // forgets all the strings
+    void clear() // throw()
+    {
+        map_.clear();
+        ring_.clear();
+        free_.clear();
+        memory_ = 0;
+        hand_ = 0;
+    }
+
+private:
+    static size_t cost(StringT const& s) // throw()
+    {
+        return sizeof(entry) + sizeof(typename map::value_type) + (s.size() + 1) * sizeof(char_type);
+    }
+
+    // forgets the first string the hand finds not referenced since its previous sweep
+    void evict() // throw()
+    {
+        for(;; hand_ = (hand_ + 1) % ring_.size())
+        {
+            entry& e(ring_[hand_]);
+            if(!e.used)
+                continue;
+            if(e.referenced)
+            {
+                e.referenced = false;
+                continue;
+            }
+            memory_ -= this->cost(e.str);
+            map_.erase(e.str);
+            e.str = value_type();
+            e.used = false;
+            free_.push_back(hand_); // can't throw, the capacity is reserved
+            hand_ = (hand_ + 1) % ring_.size();
+            return;
+        }
+    }
+
+private:
+    dedup_loader(dedup_loader const&);
+    dedup_loader& operator=(dedup_loader const&);
+
+private:
+    size_t budget_;
+    size_t memory_;
+    map map_;
+    std::vector<entry, entry_allocator> ring_;
+    std::vector<size_t, index_allocator> free_; // unused entries of the ring
+    size_t hand_;
+    size_t hits_;
+    size_t misses_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_DEDUP_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
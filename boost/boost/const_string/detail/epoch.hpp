@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// epoch.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_DETAIL_EPOCH_HPP
+#define BOOST_CONST_STRING_DETAIL_EPOCH_HPP
+
+#include "boost/config.hpp"
+#include "boost/static_assert.hpp"
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_HDR_MUTEX) && !defined(BOOST_NO_CXX11_HDR_THREAD)
+
+#include <new>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+// a small number that stays the same for the life of the calling thread
+inline size_t thread_index() // throw()
+{
+#ifndef BOOST_NO_CXX11_THREAD_LOCAL
+    static std::atomic<size_t> threads(0);
+    static thread_local size_t const index(threads.fetch_add(1, std::memory_order_relaxed));
+    return index;
+#else
+    // thread ids may be aligned addresses, the low bits are mixed with the high ones
+    size_t const h(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return ((h * 0x9e3779b9u) >> 16) ^ h;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// The readers of a structure a writer changes without waiting for them, and the writer waits
+// for them before it frees what it replaced.
+//
+// A reader registers in the counter of the current epoch for the duration of its access.
+// The counters are striped by thread over cache lines of their own, allocated apart from
+// the object and aligned, so that the readers running on different cores write no memory
+// in common, nor memory that shares a line with the epoch they read. synchronize() moves on to
+// the next epoch and waits for the readers of the previous one, so that a reader that could
+// see what was replaced before the call is over when it returns, and the readers that start
+// meanwhile don't starve it.
+
+template<size_t Stripes>
+class epoch
+{
+private:
+    enum { cache_line = 64 };
+
+    // the readers of the threads that map to it, a cache line
+    struct stripe
+    {
+        std::atomic<size_t> readers[2];
+        char padding[cache_line - 2 * sizeof(std::atomic<size_t>)];
+
+        stripe() // throw()
+        {
+            readers[0].store(0);
+            readers[1].store(0);
+        }
+    };
+
+    BOOST_STATIC_ASSERT(sizeof(stripe) == cache_line);
+
+public:
+    epoch() // throw(std::bad_alloc)
+        : memory_(new char[(Stripes + 1) * sizeof(stripe)])
+        , epoch_(0)
+    {
+        char* const first(memory_ + cache_line - reinterpret_cast<size_t>(memory_) % cache_line);
+        stripes_ = reinterpret_cast<stripe*>(first);
+        for(size_t i(0); i != Stripes; ++i)
+            new (stripes_ + i) stripe;
+    }
+
+    ~epoch()
+    {
+        delete[] memory_; // the stripes are trivially destructible
+    }
+
+public:
+    // registers a reader in the stripe of the thread for the epoch it reads in
+    class reader
+    {
+    public:
+        explicit reader(epoch const& d) // throw()
+        {
+            stripe& s(d.stripes_[thread_index() % Stripes]);
+            for(;;)
+            {
+                unsigned const e(d.epoch_.load());
+                counter_ = &s.readers[e & 1];
+                counter_->fetch_add(1);
+                // synchronize() may have moved on and stopped waiting for the readers of e
+                if(e == d.epoch_.load())
+                    break;
+                counter_->fetch_sub(1);
+            }
+        }
+
+        ~reader()
+        {
+            counter_->fetch_sub(1);
+        }
+
+    private:
+        reader(reader const&);
+        reader& operator=(reader const&);
+
+    private:
+        std::atomic<size_t>* counter_;
+    };
+
+    // a reader that started before the call is over when it returns
+    void synchronize() // throw()
+    {
+        std::lock_guard<std::mutex> lock(synchronizer_);
+        unsigned const e(epoch_.load());
+        epoch_.store(e + 1);
+        for(size_t i(0); i != Stripes; ++i)
+            while(stripes_[i].readers[e & 1].load())
+                std::this_thread::yield();
+    }
+
+private:
+    epoch(epoch const&);
+    epoch& operator=(epoch const&);
+
+private:
+    char* const memory_;
+    stripe* stripes_; // the first cache line of memory_
+    std::atomic<unsigned> epoch_;
+    std::mutex synchronizer_;
+};
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_NO_CXX11_HDR_ATOMIC
+
+#endif // BOOST_CONST_STRING_DETAIL_EPOCH_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// key.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_DETAIL_KEY_HPP
+#define BOOST_CONST_STRING_DETAIL_KEY_HPP
+
+#include <string>
+#include <algorithm>
+
+#include "boost/config.hpp"
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+#   include <string_view>
+#endif
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/hash.hpp"
+#include "boost/const_string/literal.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A lookup key of any string type for containers of StringT:
+// the characters and the size, no StringT is constructed.
+
+template<class StringT>
+struct string_key
+{
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::traits_type traits_type;
+
+    char_type const* data;
+    size_t size;
+
+    string_key(char_type const* s) // throw()
+        : data(s)
+        , size(traits_type::length(s))
+        , hash_(0)
+        , hashed_(false)
+    {}
+
+    template<class S>
+    string_key(const_string<char_type, traits_type, S> const& s) // throw()
+        : data(s.data())
+        , size(s.size())
+        , hash_(0)
+        , hashed_(false)
+    {}
+
+    template<class A>
+    string_key(std::basic_string<char_type, traits_type, A> const& s) // throw()
+        : data(s.data())
+        , size(s.size())
+        , hash_(0)
+        , hashed_(false)
+    {}
+
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+
+    string_key(std::basic_string_view<char_type, traits_type> const& s) // throw()
+        : data(s.data())
+        , size(s.size())
+        , hash_(0)
+        , hashed_(false)
+    {}
+
+#endif // BOOST_NO_CXX17_HDR_STRING_VIEW
+
+#ifndef BOOST_CONST_STRING_NO_LITERALS
+
+    string_key(const_string_literal<char_type, traits_type> const& s) // throw()
+        : data(s.data())
+        , size(s.size())
+        , hash_(s.hash())
+        , hashed_(true)
+    {}
+
+#endif // BOOST_CONST_STRING_NO_LITERALS
+
+    size_t hash() const // throw()
+    {
+        return hashed_ ? hash_ : cs::aux::hash_chars(data, size);
+    }
+
+    template<class S>
+    bool equals(const_string<char_type, traits_type, S> const& s) const // throw()
+    {
+        return size == s.size() && !traits_type::compare(data, s.data(), size);
+    }
+
+    bool equals(string_key const& b) const // throw()
+    {
+        return size == b.size && !traits_type::compare(data, b.data, size);
+    }
+
+    int compare(string_key const& b) const // throw()
+    {
+        int const res(traits_type::compare(data, b.data, std::min(size, b.size)));
+        return res ? res : size < b.size ? -1 : size != b.size;
+    }
+
+    // a copy of the key to be stored in a container, which shares the block of a StringT
+    // and copies the characters a reference doesn't keep alive, as the container may outlive them
+    static StringT make(StringT const& s, string_key const& k) // throw(std::bad_alloc)
+    {
+        return s.is_reference() ? StringT(k.data, k.size) : s;
+    }
+
+    template<class T>
+    static StringT make(T const&, string_key const& k) // throw(std::bad_alloc)
+    {
+        return StringT(k.data, k.size);
+    }
+
+private:
+    size_t hash_;
+    bool hashed_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_DETAIL_KEY_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// simd.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_DETAIL_SIMD_HPP
+#define BOOST_CONST_STRING_DETAIL_SIMD_HPP
+
+#include <cstddef>
+
+#include "boost/cstdint.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define BOOST_CONST_STRING_SSE2
+#   include <emmintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// 16-byte groups: bit n of the result is set when byte n of the group satisfies the condition
+
+enum { group_width = 16 };
+
+#ifdef BOOST_CONST_STRING_SSE2
+
+inline unsigned group_match(unsigned char const* group, unsigned char b) // throw()
+{
+    __m128i const g(_mm_loadu_si128(reinterpret_cast<__m128i const*>(group)));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(static_cast<char>(b)))));
+}
+
+// bytes with the high bit set
+inline unsigned group_match_high(unsigned char const* group) // throw()
+{
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(group))));
+}
+
+#else // BOOST_CONST_STRING_SSE2
+
+inline unsigned group_match(unsigned char const* group, unsigned char b) // throw()
+{
+    unsigned r(0);
+    for(unsigned i(0); i != group_width; ++i)
+        r |= unsigned(group[i] == b) << i;
+    return r;
+}
+
+inline unsigned group_match_high(unsigned char const* group) // throw()
+{
+    unsigned r(0);
+    for(unsigned i(0); i != group_width; ++i)
+        r |= unsigned(group[i] >> 7) << i;
+    return r;
+}
+
+#endif // BOOST_CONST_STRING_SSE2
+
+// index of the lowest set bit, mask must not be 0
+inline unsigned lowest_bit(unsigned mask) // throw()
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned r(0);
+    for(; !(mask & 1); mask >>= 1)
+        ++r;
+    return r;
+#endif
+}
+
+inline unsigned lowest_bit(boost::uint64_t mask) // throw()
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#else
+    unsigned r(0);
+    for(; !(mask & 1); mask >>= 1)
+        ++r;
+    return r;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A set of bytes to scan for, e.g. delimiters. A set of up to group_width bytes is matched
+// a group at a time, a larger one a byte at a time through the table.
+
+struct byte_set
+{
+    enum { max_vector_size = group_width };
+
+    unsigned char bytes[max_vector_size];
+    unsigned size;
+    bool member[256];
+
+    template<class CharT>
+    byte_set(CharT const* s, size_t n) // throw()
+        : size(0)
+    {
+        for(unsigned i(0); i != 256; ++i)
+            member[i] = false;
+        for(; n; --n, ++s)
+        {
+            unsigned char const b(static_cast<unsigned char>(*s));
+            if(member[b])
+                continue;
+            member[b] = true;
+            if(size < max_vector_size)
+                bytes[size] = b;
+            ++size;
+        }
+    }
+
+    bool contains(unsigned char b) const // throw()
+    {
+        return member[b];
+    }
+};
+
+#ifdef BOOST_CONST_STRING_SSE2
+
+inline unsigned group_match(unsigned char const* group, byte_set const& set) // throw()
+{
+    __m128i const g(_mm_loadu_si128(reinterpret_cast<__m128i const*>(group)));
+    __m128i m(_mm_setzero_si128());
+    for(unsigned i(0); i != set.size; ++i)
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(g, _mm_set1_epi8(static_cast<char>(set.bytes[i]))));
+    return static_cast<unsigned>(_mm_movemask_epi8(m));
+}
+
+#else // BOOST_CONST_STRING_SSE2
+
+inline unsigned group_match(unsigned char const* group, byte_set const& set) // throw()
+{
+    unsigned r(0);
+    for(unsigned i(0); i != group_width; ++i)
+        r |= unsigned(set.contains(group[i])) << i;
+    return r;
+}
+
+#endif // BOOST_CONST_STRING_SSE2
+
+// the first byte of [first, last) in the set or last, 64 bytes a step
+inline unsigned char const* find_byte(unsigned char const* first, unsigned char const* last, byte_set const& set) // throw()
+{
+    if(set.size <= byte_set::max_vector_size)
+    {
+        for(; last - first >= 4 * group_width; first += 4 * group_width)
+        {
+            boost::uint64_t const m(
+                  boost::uint64_t(group_match(first, set))
+                | boost::uint64_t(group_match(first + group_width, set)) << group_width
+                | boost::uint64_t(group_match(first + 2 * group_width, set)) << 2 * group_width
+                | boost::uint64_t(group_match(first + 3 * group_width, set)) << 3 * group_width
+                );
+            if(m)
+                return first + lowest_bit(m);
+        }
+        for(; last - first >= group_width; first += group_width)
+            if(unsigned const m = group_match(first, set))
+                return first + lowest_bit(m);
+    }
+    for(; first != last && !set.contains(*first); ++first)
+        ;
+    return first;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_DETAIL_SIMD_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
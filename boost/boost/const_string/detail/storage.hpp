@@ -10,12 +10,16 @@
 #ifndef BOOST_CONST_STRING_DETAIL_STORAGE_HPP
 #define BOOST_CONST_STRING_DETAIL_STORAGE_HPP
 
+#include <cstring>
 #include <limits>
 #include <new>
 #include <memory>
 
+#include "boost/config.hpp"
 #include "boost/aligned_storage.hpp"
 #include "boost/detail/atomic_count.hpp"
+#include "boost/type_traits/integral_constant.hpp"
+#include "boost/type_traits/is_empty.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -27,6 +31,86 @@ namespace boost
 namespace cs {
 namespace aux {
 
+template<class char_type>
+struct zero_string_literal
+{
+    static char_type const value[1];
+};
+
+template<class char_type>
+char_type const zero_string_literal<char_type>::value[1] = { 0 };
+
+// the owner of characters that strings refer to in place, e.g. a string table,
+// it is destroyed by the string or the owner's user that releases the last reference
+struct external_owner
+{
+    boost::detail::atomic_count counter;
+    void (*destroy)(external_owner*);
+    bool terminated; // whether the characters of its slices are followed by a zero
+
+    explicit external_owner(void (*d)(external_owner*), bool t = true)
+        : counter(1)
+        , destroy(d)
+        , terminated(t)
+    {}
+};
+
+inline void release(external_owner* owner) // throw()
+{
+    if(0 == --owner->counter)
+        owner->destroy(owner);
+}
+
+// the characters of one string of an owner, it must live as long as the owner
+template<class CharT>
+struct external_slice
+{
+    external_owner* owner;
+    CharT const* data;
+    size_t size;
+};
+
+// the owner of a buffer adopted by a string, e.g. an arena or a receive buffer,
+// it calls the release function when the last string referring to the buffer is gone
+template<class CharT>
+struct adopted_buffer : external_owner
+{
+    typedef void (*release_function)(void* context, CharT const* data, size_t size);
+
+    external_slice<CharT> slice;
+    release_function release_buffer;
+    void* context;
+
+    adopted_buffer(CharT const* data, size_t size, release_function r, void* c) // throw()
+        : external_owner(&adopted_buffer::destroy, false)
+        , release_buffer(r)
+        , context(c)
+    {
+        slice.owner = this;
+        slice.data = data;
+        slice.size = size;
+    }
+
+    static void destroy(external_owner* o) // throw(), the release function must not throw
+    {
+        adopted_buffer* const p(static_cast<adopted_buffer*>(o));
+        release_function const r(p->release_buffer);
+        void* const c(p->context);
+        CharT const* const data(p->slice.data);
+        size_t const size(p->slice.size);
+        delete p;
+        if(r)
+            r(c, data, size);
+    }
+};
+
+template<class TraitsT, class CharT>
+inline int compare_chars(CharT const* a, size_t a_size, CharT const* b, size_t b_size) // throw()
+{
+    int const res(TraitsT::compare(a, b, a_size < b_size ? a_size : b_size));
+    return res ? res : a_size < b_size ? -1 : a_size != b_size;
+}
+
 // Ben Hutchings reported:
 //
 // There's one possible problem I noticed, which is that an allocated
@@ -68,6 +152,19 @@ struct aligned_union
 //         then a copy of the source sting is stored in the buffer inside the string
 //     else
 //         it allocates and shares reference counted copy of the string
+//
+// an allocated shared copy can be made immortal: it is never freed and copies of it
+// don't touch the reference counter
+//
+// a string may also refer to a slice of characters of an external owner, then the pointer
+// points to the slice and the owner's reference counter is shared instead
+//
+// the copies are always followed by a zero, referenced characters are known to be
+// when the reference constructor is given a nonzero last argument or the owner says so,
+// so that c_str() never has to read past the end to find out
+//
+// a storage constructed with a null source leaves the characters to be written by the string
+// through begin(), after that the string calls seal()
 
 template<
       class TraitsT
@@ -103,18 +200,23 @@ private:
     typedef size_t state_type;
     static state_type const shared_bit_mask = state_type(1) << (std::numeric_limits<state_type>::digits - 1);
     static state_type const allocated_bit_mask = shared_bit_mask >> 1;
-    static state_type const size_bit_mask = allocated_bit_mask - 1;
+    static state_type const immortal_bit_mask = allocated_bit_mask >> 1;
+    static state_type const external_bit_mask = immortal_bit_mask >> 1;
+    static state_type const terminated_bit_mask = external_bit_mask >> 1;
+    static state_type const kind_bit_mask = shared_bit_mask | allocated_bit_mask | immortal_bit_mask | external_bit_mask;
+    static state_type const flags_bit_mask = kind_bit_mask | terminated_bit_mask;
+    static state_type const size_bit_mask = terminated_bit_mask - 1;
 
 public:
     enum { effective_buffer_size_chars = effective_buffer_size / sizeof(char_type) };
 
 public:
-    const_string_storage(char_type const* begin, size_t length, int /*reference_semantics*/)
+    const_string_storage(char_type const* begin, size_t length, int terminated)
     {
         if(length > this->max_size())
             throw std::length_error("const_string: the source string is way too long");
 
-        state_ = length | shared_bit_mask;
+        state_ = length | shared_bit_mask | (terminated ? terminated_bit_mask : 0);
         *this->as_shared() = begin;
     }
 
@@ -125,6 +227,7 @@ public:
 
         state_ = length
             | allocated_bit_mask
+            | terminated_bit_mask
             | (length > effective_buffer_size_chars - 1 ? shared_bit_mask : 0)
             ;
 
@@ -132,14 +235,7 @@ public:
 
         if(this->is_shared())
         {
-            size_t const character_bytes((length + 1) * sizeof(char_type));
-            size_t const elements(
-                  1
-                + character_bytes / sizeof(typename allocator::value_type) 
-                + (0 != character_bytes % sizeof(typename allocator::value_type))
-                );
-
-            void* const p(this->allocator::allocate(elements));
+            void* const p(this->allocator::allocate(this->elements(length)));
 			new (p) boost::detail::atomic_count(1);
             copy = reinterpret_cast<char_type*>(reinterpret_cast<size_t>(p) + sizeof(typename allocator::value_type));
             *this->as_shared() = copy;
@@ -155,20 +251,52 @@ public:
         copy[length] = char_type();
     }
 
+    explicit const_string_storage(cs::aux::external_slice<char_type> const& slice) // throw(std::length_error)
+    {
+        if(slice.size > this->max_size())
+            throw std::length_error("const_string: the source string is way too long");
+
+        state_ = slice.size
+            | shared_bit_mask
+            | external_bit_mask
+            | (slice.owner->terminated ? terminated_bit_mask : 0)
+            ;
+        *this->as_external() = &slice;
+        ++slice.owner->counter;
+    }
+
     const_string_storage(const_string_storage const& other) // throw()
         : allocator(other)
         , state_(other.state_)
     {
-        if(this->is_shared())
+        if(this->is_external())
+        {
+            *this->as_external() = *other.as_external();
+            if(this->is_owned())
+                ++(*this->as_external())->owner->counter;
+        }
+        else if(this->is_shared())
         {
             *this->as_shared() = *other.as_shared();
-            if(this->is_allocated())
+            if(this->is_counted())
                 ++this->counter();
         }
         else
             TraitsT::copy(this->as_buffer(), other.as_buffer(), effective_buffer_size_chars);
     }
 
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+    const_string_storage(const_string_storage&& other) BOOST_NOEXCEPT
+        : allocator(other)
+        , state_(shared_bit_mask | terminated_bit_mask)
+    {
+        *this->as_shared() = cs::aux::zero_string_literal<char_type>::value;
+        this->swap(other);
+    }
+
+#endif // BOOST_NO_CXX11_RVALUE_REFERENCES
+
     const_string_storage const& operator=(const_string_storage const& other) // throw()
     {
         if(this != &other)
@@ -186,14 +314,66 @@ public:
     }
 
 public:
-    const_string_storage& set_size(size_t length)
+    void swap(const_string_storage& other) // throw()
+    {
+        this->swap(other, boost::is_empty<allocator>());
+    }
+
+private:
+    void swap(const_string_storage& other, boost::true_type) // throw()
+    {
+        // the buffer is never pointed into, so that the objects can be relocated bytewise
+        // without touching the reference counter
+        boost::aligned_storage<sizeof(const_string_storage), boost::alignment_of<const_string_storage>::value> t;
+        std::memcpy(t.address(), static_cast<void*>(this), sizeof(const_string_storage));
+        std::memcpy(static_cast<void*>(this), static_cast<void*>(&other), sizeof(const_string_storage));
+        std::memcpy(static_cast<void*>(&other), t.address(), sizeof(const_string_storage));
+    }
+
+    void swap(const_string_storage& other, boost::false_type) // throw()
+    {
+        const_string_storage const t(*this);
+        *this = other;
+        other = t;
+    }
+
+public:
+    // the characters must be followed by a zero at the new size. A shared block is freed
+    // with the size it was allocated for, so that when the new size needs fewer elements
+    // the characters are moved to a block of the new size, or inside when they fit
+    const_string_storage& set_size(size_t length) // throw(std::bad_alloc, std::length_error)
     {
         if(length > this->size())
             throw std::length_error("const_string: the source string is way too long");
-        state_ = state_ & (allocated_bit_mask | shared_bit_mask) | length;
+        if(this->is_counted() && this->elements(length) != this->elements(this->size()))
+        {
+            const_string_storage copy(this->begin(), length);
+            this->swap(copy);
+        }
+        else
+            state_ = (state_ & flags_bit_mask) | length;
         return *this;
     }
 
+    void seal() // throw()
+    {}
+
+    void make_immortal() // throw()
+    {
+        // the reference that is never released keeps the block alive
+        // for the copies made before this call
+        if(this->is_counted())
+        {
+            ++this->counter();
+            state_ |= immortal_bit_mask;
+        }
+        else if(this->is_owned())
+        {
+            ++(*this->as_external())->owner->counter;
+            state_ |= immortal_bit_mask;
+        }
+    }
+
 public:
     size_t max_size() const
     {
@@ -208,7 +388,7 @@ public:
     char_type const* begin() const
     {
         return this->is_shared()
-            ? *this->as_shared()
+            ? (this->is_external() ? (*this->as_external())->data : *this->as_shared())
             : this->as_buffer()
             ;
     }
@@ -218,32 +398,53 @@ public:
         return this->begin() + this->size();
     }
 
+    int compare(const_string_storage const& other) const // throw()
+    {
+        return cs::aux::compare_chars<traits_type>(this->begin(), this->size(), other.begin(), other.size());
+    }
+
+    bool is_terminated() const // throw()
+    {
+        return 0 != (state_ & terminated_bit_mask);
+    }
+
+    // whether the characters are neither a copy nor kept alive by an owner
+    bool is_reference() const // throw()
+    {
+        return shared_bit_mask == (state_ & kind_bit_mask);
+    }
+
 private:
     void reset()
     {
-        if((allocated_bit_mask | shared_bit_mask) == (state_ & (allocated_bit_mask | shared_bit_mask)))
+        if(this->is_counted())
         {
             if(0 == --this->counter())
 			{
-                size_t const character_bytes((this->size() + 1) * sizeof(char_type));
-                size_t const elements(
-                      1
-                    + character_bytes / sizeof(typename allocator::value_type) 
-                    + (0 != character_bytes % sizeof(typename allocator::value_type))
-                    );
-
 				boost::detail::atomic_count* const p(&this->counter());
 				// g++ 3.2.3 needs it for the next line when atomic_count is long int
 				using boost::detail::atomic_count; 
 				p->~atomic_count();
 
-                this->allocator::deallocate(reinterpret_cast<typename allocator::pointer>(p), elements);
+                this->allocator::deallocate(reinterpret_cast<typename allocator::pointer>(p), this->elements(this->size()));
 			}
         }
+        else if(this->is_owned())
+            cs::aux::release((*this->as_external())->owner);
         state_ = 0;
         *this->as_shared() = 0;
     }
 
+    // of a shared block: the counter and the characters with the trailing zero
+    static size_t elements(size_t length)
+    {
+        size_t const character_bytes((length + 1) * sizeof(char_type));
+        return 1
+            + character_bytes / sizeof(typename allocator::value_type)
+            + (0 != character_bytes % sizeof(typename allocator::value_type))
+            ;
+    }
+
     bool is_allocated() const
     {
         return 0 != (state_ & allocated_bit_mask);
@@ -254,6 +455,21 @@ private:
         return 0 != (state_ & shared_bit_mask);
     }
 
+    bool is_counted() const
+    {
+        return (allocated_bit_mask | shared_bit_mask) == (state_ & kind_bit_mask);
+    }
+
+    bool is_external() const
+    {
+        return 0 != (state_ & external_bit_mask);
+    }
+
+    bool is_owned() const
+    {
+        return (external_bit_mask | shared_bit_mask) == (state_ & kind_bit_mask);
+    }
+
     char_type* as_buffer() const
     {
         return static_cast<char_type*>(const_cast<aligned_storage&>(stg_).address()); 
@@ -264,6 +480,11 @@ private:
         return static_cast<char_type const**>(const_cast<aligned_storage&>(stg_).address()); 
     }
 
+    cs::aux::external_slice<char_type> const** as_external() const
+    {
+        return static_cast<cs::aux::external_slice<char_type> const**>(const_cast<aligned_storage&>(stg_).address());
+    }
+
     boost::detail::atomic_count& counter()
     {
         return *reinterpret_cast<boost::detail::atomic_count*>(
@@ -280,6 +501,23 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace cs {
+namespace aux {
+
+// whether a storage can refer to the characters of an external_owner
+template<class StorageT>
+struct can_refer_external : boost::false_type {};
+
+template<class TraitsT, class AllocatorT, size_t buffer_size, size_t buffer_alignment>
+struct can_refer_external<const_string_storage<TraitsT, AllocatorT, buffer_size, buffer_alignment> >
+    : boost::true_type
+{};
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace boost
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// file.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_FILE_HPP
+#define BOOST_CONST_STRING_FILE_HPP
+
+#include "boost/config.hpp"
+
+#ifdef BOOST_HAS_UNISTD_H
+
+#include <vector>
+#include <string>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "boost/static_assert.hpp"
+#include "boost/type_traits/is_same.hpp"
+
+#include "boost/const_string/const_string.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+inline void throw_file_error(char const* what, char const* path, int error) // throw(std::runtime_error)
+{
+    throw std::runtime_error(std::string("read_file: ") + what + " " + path + ": " + std::strerror(error));
+}
+
+// closes the descriptor on the way out
+class file_descriptor
+{
+public:
+    explicit file_descriptor(char const* path) // throw(std::runtime_error)
+    {
+#ifdef O_CLOEXEC
+        int const flags(O_RDONLY | O_CLOEXEC); // not inherited by the processes started meanwhile
+#else
+        int const flags(O_RDONLY);
+#endif
+        do
+            fd_ = ::open(path, flags);
+        while(fd_ < 0 && EINTR == errno);
+        if(fd_ < 0)
+            throw_file_error("open", path, errno);
+    }
+
+    ~file_descriptor()
+    {
+        ::close(fd_);
+    }
+
+    int get() const { return fd_; } // throw()
+
+    // the bytes read, fewer than n at the end of the file only
+    size_t read(char* to, size_t n, char const* path) const // throw(std::runtime_error)
+    {
+        size_t done(0);
+        while(done != n)
+        {
+            ssize_t const r(::read(fd_, to + done, n - done));
+            if(r < 0)
+            {
+                if(EINTR == errno)
+                    continue;
+                throw_file_error("read", path, errno);
+            }
+            if(!r)
+                break;
+            done += r;
+        }
+        return done;
+    }
+
+private:
+    file_descriptor(file_descriptor const&);
+    file_descriptor& operator=(file_descriptor const&);
+
+private:
+    int fd_;
+};
+
+// a read-only mapping of a file that strings refer to in place, unmapped with the last one
+struct mapped_file : external_owner
+{
+    external_slice<char> slice;
+
+    // the rest of the last page of a mapping reads as zeros, so that the characters
+    // are followed by a zero unless the size is a multiple of the page size
+    mapped_file(void* p, size_t size) // throw()
+        : external_owner(&mapped_file::destroy, 0 != size % static_cast<size_t>(::sysconf(_SC_PAGESIZE)))
+    {
+        slice.owner = this;
+        slice.data = static_cast<char const*>(p);
+        slice.size = size;
+    }
+
+    static void destroy(external_owner* o) // throw()
+    {
+        mapped_file* const p(static_cast<mapped_file*>(o));
+        ::munmap(const_cast<char*>(p->slice.data), p->slice.size);
+        delete p;
+    }
+};
+
+template<class StringT>
+inline bool map_file(file_descriptor const& fd, size_t size, char const* path, StringT& s, boost::true_type) // throw(std::bad_alloc, std::runtime_error)
+{
+    typedef typename StringT::storage_type storage_type;
+
+    void* const p(::mmap(0, size, PROT_READ, MAP_PRIVATE, fd.get(), 0));
+    if(MAP_FAILED == p)
+        throw_file_error("mmap", path, errno);
+    mapped_file* owner;
+    try
+    {
+        owner = new mapped_file(p, size);
+    }
+    catch(...)
+    {
+        ::munmap(p, size);
+        throw;
+    }
+    try
+    {
+        s = StringT(storage_type(owner->slice));
+        cs::aux::release(owner); // the string holds the owner from now on
+        return true;
+    }
+    catch(...)
+    {
+        cs::aux::release(owner);
+        throw;
+    }
+}
+
+// a storage that can't refer to a mapping reads the file
+template<class StringT>
+inline bool map_file(file_descriptor const&, size_t, char const*, StringT&, boost::false_type) // throw()
+{
+    return false;
+}
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Reads a file into a string with no copy on the way, e.g. the configuration and templates
+// loaded at startup.
+//
+// The size of a regular file is taken with fstat(), the block of the string is allocated
+// at that size and read() fills it, so that the file costs one allocation and no copy.
+// A file of mmap_threshold bytes or more is mapped read-only instead when the storage can
+// refer to external characters, as const_string_storage can: the string refers to the mapping,
+// which is unmapped when the last copy of the string is gone. A mapped string sees the changes
+// made to the file afterwards, and truncating the file makes reading the string fault,
+// so map only files nobody writes. Pass static_cast<size_t>(-1) to always read.
+//
+// Files whose size fstat() can't tell, such as pipes and the files of /proc, are read
+// in chunks and copied once.
+//
+// Errors throw std::runtime_error with the path and strerror().
+//
+//     const_string<char> const config(read_file("/etc/service.conf"));
+
+template<class StringT>
+StringT read_file(char const* path, size_t mmap_threshold) // throw(std::bad_alloc, std::length_error, std::runtime_error)
+{
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::storage_type storage_type;
+    BOOST_STATIC_ASSERT((boost::is_same<char_type, char>::value)); // a file is read into chars
+
+    cs::aux::file_descriptor const fd(path);
+    struct stat st;
+    if(::fstat(fd.get(), &st))
+        cs::aux::throw_file_error("fstat", path, errno);
+    size_t const size(static_cast<size_t>(st.st_size));
+
+    if(!S_ISREG(st.st_mode) || !size)
+    {
+        std::vector<char> bytes;
+        for(size_t n(0x1000); true; n *= 2)
+        {
+            size_t const old(bytes.size());
+            bytes.resize(old + n);
+            size_t const r(fd.read(&bytes[old], n, path));
+            bytes.resize(old + r);
+            if(r < n)
+                break;
+        }
+        return bytes.empty() ? StringT() : StringT(&bytes[0], &bytes[0] + bytes.size());
+    }
+
+    StringT mapped;
+    if(size >= mmap_threshold && cs::aux::map_file(fd, size, path, mapped, cs::aux::can_refer_external<storage_type>()))
+        return mapped;
+
+    storage_type stg(0, size);
+    char* const p(reinterpret_cast<char*>(const_cast<char_type*>(stg.begin())));
+    size_t const r(fd.read(p, size, path));
+    if(r != size)
+    {
+        // the file was truncated after fstat()
+        p[r] = 0;
+        stg.set_size(r);
+    }
+    stg.seal();
+    return StringT(stg);
+}
+
+// a file of a megabyte or more is mapped
+inline const_string<char> read_file(char const* path, size_t mmap_threshold = 0x100000) // throw(std::bad_alloc, std::length_error, std::runtime_error)
+{
+    return read_file<const_string<char> >(path, mmap_threshold);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_HAS_UNISTD_H
+
+#endif // BOOST_CONST_STRING_FILE_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -11,9 +11,22 @@
 #define BOOST_CONST_STRING_FORMAT_HPP
 
 #include <stdarg.h>
+#include <stdio.h>
+#ifndef BOOST_NO_CWCHAR
+#   include <wchar.h>
+#endif // BOOST_NO_CWCHAR
 
 #include "boost/const_string/const_string.hpp"
 
+// vsnprintf() consumes its va_list, so each formatting attempt needs a fresh copy
+#if defined(va_copy)
+#   define BOOST_CONST_STRING_VA_COPY(d, s) va_copy(d, s)
+#elif defined(__va_copy)
+#   define BOOST_CONST_STRING_VA_COPY(d, s) __va_copy(d, s)
+#else
+#   define BOOST_CONST_STRING_VA_COPY(d, s) ((d) = (s))
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace boost {
@@ -25,25 +38,33 @@ namespace aux {
 
 inline int do_format(char* s, size_t n, char const* fmt, va_list args)
 {
+    va_list copy;
+    BOOST_CONST_STRING_VA_COPY(copy, args);
 #if defined(BOOST_MSVC) || defined(BOOST_INTEL_WIN)
-    return ::_vsnprintf(s, n, fmt, args);
+    int const r(::_vsnprintf(s, n, fmt, copy));
 #else
-    return ::vsnprintf(s, n, fmt, args);
+    int const r(::vsnprintf(s, n, fmt, copy));
 #endif
+    va_end(copy);
+    return r;
 }
 
 #ifndef BOOST_NO_CWCHAR
 
 inline int do_format(wchar_t* s, size_t n, wchar_t const* fmt, va_list args)
 {
+    va_list copy;
+    BOOST_CONST_STRING_VA_COPY(copy, args);
 #if defined(BOOST_MSVC) || defined(BOOST_INTEL_WIN)
-    return ::_vsnwprintf(s, n, fmt, args);
+    int const r(::_vsnwprintf(s, n, fmt, copy));
 //#elif defined(__MWERKS__) || defined(__GNUC__)
 #else
-    return ::vswprintf(s, n, fmt, args);
+    int const r(::vswprintf(s, n, fmt, copy));
 //#else
-//    return ::vsnwprintf(s, n, fmt, args);
+//    int const r(::vsnwprintf(s, n, fmt, copy));
 #endif
+    va_end(copy);
+    return r;
 }
 
 #endif // BOOST_NO_CWCHAR
@@ -157,6 +178,8 @@ inline ConstStringT cs_format(size_t hint, typename ConstStringT::char_type cons
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
+#undef BOOST_CONST_STRING_VA_COPY
+
 #endif // BOOST_CONST_STRING_FORMAT_HPP
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
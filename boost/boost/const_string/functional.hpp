@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// functional.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_FUNCTIONAL_HPP
+#define BOOST_CONST_STRING_FUNCTIONAL_HPP
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/detail/key.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Transparent function objects for standard containers of const_string.
+//
+// Each takes any string type cs::aux::string_key<> accepts: character pointers, const_string,
+// std::basic_string, std::basic_string_view and const_string_literal. With is_transparent
+// std::map<>::find() (C++14) and std::unordered_map<>::find() (C++20) look such keys up
+// without constructing a temporary const_string.
+//
+//     std::map<const_string<char>, int, const_string_less<> > m;
+//     m.find("literal");
+
+template<class StringT = const_string<char> >
+struct const_string_hash
+{
+    typedef void is_transparent;
+    typedef size_t result_type;
+    typedef cs::aux::string_key<StringT> key;
+
+    size_t operator()(key const& k) const // throw()
+    {
+        return k.hash();
+    }
+};
+
+template<class StringT = const_string<char> >
+struct const_string_equal_to
+{
+    typedef void is_transparent;
+    typedef bool result_type;
+    typedef cs::aux::string_key<StringT> key;
+
+    bool operator()(key const& a, key const& b) const // throw()
+    {
+        return a.equals(b);
+    }
+};
+
+template<class StringT = const_string<char> >
+struct const_string_less
+{
+    typedef void is_transparent;
+    typedef bool result_type;
+    typedef cs::aux::string_key<StringT> key;
+
+    bool operator()(key const& a, key const& b) const // throw()
+    {
+        return a.compare(b) < 0;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_FUNCTIONAL_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
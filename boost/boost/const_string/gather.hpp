@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// gather.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_GATHER_HPP
+#define BOOST_CONST_STRING_GATHER_HPP
+
+#include "boost/config.hpp"
+
+#ifdef BOOST_HAS_UNISTD_H
+
+#include <vector>
+#include <string>
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/concatenation.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Collects strings and concatenation expressions to write them to a file descriptor with
+// one writev() or sendmsg() call, e.g. the header and body pieces of a response.
+//
+// The pieces are not copied: the writer keeps a copy of every string, which shares its block,
+// so that the characters stay alive until they have been written, and hands the system
+// a struct iovec per piece. The pieces of a concatenation that were not const_strings,
+// such as char arrays or std::strings, are referred to, as boost::cref() does,
+// and must live until they are written.
+//
+// write_to() and send_to() write as much as the descriptor takes, IOV_MAX pieces a call,
+// retry on EINTR and return false on EAGAIN with the rest kept for the next call.
+// Other errors throw std::runtime_error.
+//
+//     gather_writer<> w;
+//     w << status_line << headers << lit("\r\n") << body;
+//     w.write_to(socket);
+
+template<class StringT = const_string<char> >
+class gather_writer
+{
+public:
+    typedef StringT value_type;
+    typedef typename StringT::char_type char_type;
+
+private:
+#ifdef IOV_MAX
+    enum { batch = IOV_MAX < 1024 ? IOV_MAX : 1024 };
+#else
+    enum { batch = 16 };
+#endif
+
+public:
+    gather_writer() // throw()
+        : first_(0)
+        , offset_(0)
+        , bytes_(0)
+    {}
+
+public:
+    gather_writer& append(StringT const& s) // throw(std::bad_alloc)
+    {
+        if(!s.empty())
+        {
+            pieces_.push_back(s);
+            bytes_ += s.size() * sizeof(char_type);
+        }
+        return *this;
+    }
+
+    template<class T, class U>
+    gather_writer& append(concatenation<StringT, T, U> const& e) // throw(std::bad_alloc)
+    {
+        e.for_each_piece(*this);
+        return *this;
+    }
+
+    template<class T>
+    gather_writer& operator<<(T const& t) // throw(std::bad_alloc)
+    {
+        return this->append(t);
+    }
+
+    // for concatenation<>::for_each_piece()
+    void operator()(StringT const& s) // throw(std::bad_alloc)
+    {
+        this->append(s);
+    }
+
+    // the bytes not written yet
+    size_t size() const { return bytes_; } // throw()
+    bool empty() const { return !bytes_; } // throw()
+
+    void clear() // throw()
+    {
+        pieces_.clear();
+        first_ = 0;
+        offset_ = 0;
+        bytes_ = 0;
+    }
+
+    // writes the pieces with writev(), true when they all are written
+    bool write_to(int fd) // throw(std::runtime_error)
+    {
+        return this->flush(fd, 0, false);
+    }
+
+    // sends the pieces with sendmsg(), true when they all are sent
+    bool send_to(int socket, int flags = 0) // throw(std::runtime_error)
+    {
+        return this->flush(socket, flags, true);
+    }
+
+private:
+    bool flush(int fd, int flags, bool send)
+    {
+        while(first_ != pieces_.size())
+        {
+            // the iovecs are made now, as the characters of short strings move with the vector
+            iovec iov[batch];
+            int n(0);
+            for(size_t i(first_); i != pieces_.size() && n != batch; ++i, ++n)
+            {
+                size_t const skip(i == first_ ? offset_ : 0);
+                iov[n].iov_base = const_cast<char*>(reinterpret_cast<char const*>(pieces_[i].data()) + skip);
+                iov[n].iov_len = pieces_[i].size() * sizeof(char_type) - skip;
+            }
+
+            ssize_t r;
+            if(send)
+            {
+                msghdr msg;
+                std::memset(&msg, 0, sizeof msg);
+                msg.msg_iov = iov;
+                msg.msg_iovlen = n;
+                r = ::sendmsg(fd, &msg, flags);
+            }
+            else
+                r = ::writev(fd, iov, n);
+
+            if(r < 0)
+            {
+                int const error(errno);
+                if(EINTR == error)
+                    continue;
+                if(EAGAIN == error || EWOULDBLOCK == error)
+                    return false;
+                throw std::runtime_error(std::string(send ? "gather_writer: sendmsg: " : "gather_writer: writev: ") + std::strerror(error));
+            }
+            this->consume(static_cast<size_t>(r));
+        }
+        this->clear();
+        return true;
+    }
+
+    // releases the pieces written
+    void consume(size_t n) // throw()
+    {
+        bytes_ -= n;
+        while(n)
+        {
+            size_t const left(pieces_[first_].size() * sizeof(char_type) - offset_);
+            if(n < left)
+            {
+                offset_ += n;
+                return;
+            }
+            n -= left;
+            pieces_[first_++] = StringT();
+            offset_ = 0;
+        }
+    }
+
+private:
+    std::vector<StringT> pieces_;
+    size_t first_; // the first piece not written completely
+    size_t offset_; // the bytes of it written
+    size_t bytes_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_HAS_UNISTD_H
+
+#endif // BOOST_CONST_STRING_GATHER_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
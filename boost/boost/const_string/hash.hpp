@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// hash.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_HASH_HPP
+#define BOOST_CONST_STRING_HASH_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "boost/config.hpp"
+
+#include "boost/const_string/const_string_fwd.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// FNV-1a parameters for the width of size_t
+
+template<size_t size>
+struct fnv1a;
+
+template<>
+struct fnv1a<4>
+{
+    static BOOST_CONSTEXPR_OR_CONST size_t basis = 2166136261u;
+    static BOOST_CONSTEXPR_OR_CONST size_t prime = 16777619u;
+};
+
+template<>
+struct fnv1a<8>
+{
+    // shifts are split not to overflow when this specialization is parsed on a 32-bit platform
+    static BOOST_CONSTEXPR_OR_CONST size_t basis = size_t(0xcbf29ce4u) << 16 << 16 | 0x84222325u;
+    static BOOST_CONSTEXPR_OR_CONST size_t prime = size_t(0x100u) << 16 << 16 | 0x000001b3u;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the one hash function of the library, it is constexpr since C++14,
+// so that hashes of literals computed at compile time match those of const_string
+template<class CharT>
+inline BOOST_CXX14_CONSTEXPR
+size_t hash_chars(CharT const* s, size_t n) // throw()
+{
+    typedef fnv1a<sizeof(size_t)> fnv;
+    size_t h(fnv::basis);
+    for(; n; --n, ++s)
+    {
+        h ^= static_cast<size_t>(*s);
+        h *= fnv::prime;
+    }
+    return h;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+// found by boost::hash<> via argument dependent lookup
+template<class CharT, class TraitsT, class S>
+inline size_t hash_value(const_string<CharT, TraitsT, S> const& s) // throw()
+{
+    return cs::aux::hash_chars(s.data(), s.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_HASH_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
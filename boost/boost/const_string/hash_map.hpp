@@ -0,0 +1,529 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// hash_map.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_HASH_MAP_HPP
+#define BOOST_CONST_STRING_HASH_MAP_HPP
+
+#include <new>
+#include <memory>
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+
+#include "boost/type_traits/integral_constant.hpp"
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/relocatable.hpp"
+#include "boost/const_string/detail/key.hpp"
+#include "boost/const_string/detail/simd.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Open addressing hash table with a control byte per slot.
+//
+// The control bytes are probed in groups of 16 with one SIMD comparison: a full slot has
+// the low 7 bits of the hash in its control byte, so that the keys are compared only
+// for 1/128 of unrelated slots. Lookups take any type string_key<> accepts,
+// the characters are hashed once per operation and no StringT is constructed.
+
+template<class StringT, class ValueT, class KeyOfT, class AllocatorT>
+class flat_table
+    : private AllocatorT::template rebind<ValueT>::other
+{
+private:
+    typedef typename AllocatorT::template rebind<ValueT>::other allocator;
+    typedef typename AllocatorT::template rebind<unsigned char>::other ctrl_allocator;
+    typedef cs::aux::string_key<StringT> key;
+
+    enum { ctrl_empty = 0x80, ctrl_deleted = 0xfe };
+
+public:
+    typedef StringT key_type;
+    typedef ValueT value_type;
+    typedef size_t size_type;
+
+    template<class V>
+    class basic_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef V value_type;
+        typedef ptrdiff_t difference_type;
+        typedef V* pointer;
+        typedef V& reference;
+
+    public:
+        basic_iterator() : ctrl_(0), slot_(0), end_(0) {} // throw()
+
+        template<class U>
+        basic_iterator(basic_iterator<U> const& other) // throw()
+            : ctrl_(other.ctrl_)
+            , slot_(other.slot_)
+            , end_(other.end_)
+        {}
+
+        V& operator*() const { return *slot_; } // throw()
+        V* operator->() const { return slot_; } // throw()
+
+        basic_iterator& operator++() // throw()
+        {
+            ++ctrl_;
+            ++slot_;
+            this->skip_free();
+            return *this;
+        }
+
+        basic_iterator operator++(int) // throw()
+        {
+            basic_iterator const t(*this);
+            ++*this;
+            return t;
+        }
+
+        template<class U>
+        bool operator==(basic_iterator<U> const& other) const { return slot_ == other.slot_; } // throw()
+        template<class U>
+        bool operator!=(basic_iterator<U> const& other) const { return slot_ != other.slot_; } // throw()
+
+    private:
+        template<class, class, class, class> friend class flat_table;
+        template<class> friend class basic_iterator;
+
+        basic_iterator(unsigned char const* ctrl, V* slot, unsigned char const* end) // throw()
+            : ctrl_(ctrl)
+            , slot_(slot)
+            , end_(end)
+        {}
+
+        void skip_free() // throw()
+        {
+            for(; ctrl_ != end_ && (*ctrl_ & 0x80); ++ctrl_)
+                ++slot_;
+        }
+
+        unsigned char const* ctrl_;
+        V* slot_;
+        unsigned char const* end_;
+    };
+
+    typedef basic_iterator<ValueT> iterator;
+    typedef basic_iterator<ValueT const> const_iterator;
+
+public:
+    flat_table() // throw()
+        : ctrl_(0)
+        , slots_(0)
+        , capacity_(0)
+        , size_(0)
+        , free_(0)
+    {}
+
+    flat_table(flat_table const& other) // throw(std::bad_alloc)
+        : allocator(other)
+        , ctrl_(0)
+        , slots_(0)
+        , capacity_(0)
+        , size_(0)
+        , free_(0)
+    {
+        if(other.size())
+            this->reserve(other.size());
+        for(const_iterator i(other.begin()), e(other.end()); i != e; ++i)
+        {
+            key const k(KeyOfT::get(*i));
+            this->insert_unique(k.hash(), *i);
+        }
+    }
+
+    flat_table& operator=(flat_table const& other) // throw(std::bad_alloc)
+    {
+        flat_table(other).swap(*this);
+        return *this;
+    }
+
+    ~flat_table()
+    {
+        this->destroy();
+    }
+
+public:
+    iterator begin() { return this->make_iterator<iterator>(0); } // throw()
+    iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_); } // throw()
+    const_iterator begin() const { return this->make_iterator<const_iterator>(0); } // throw()
+    const_iterator end() const { return const_iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_); } // throw()
+
+    size_t size() const { return size_; } // throw()
+    bool empty() const { return !size_; } // throw()
+    size_t bucket_count() const { return capacity_; } // throw()
+
+public:
+    template<class K>
+    iterator find(K const& k) // throw()
+    {
+        key const kk(k);
+        size_t const index(this->find_index(kk, kk.hash()));
+        return npos == index ? this->end() : iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+    }
+
+    template<class K>
+    const_iterator find(K const& k) const // throw()
+    {
+        key const kk(k);
+        size_t const index(this->find_index(kk, kk.hash()));
+        return npos == index ? this->end() : const_iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+    }
+
+    template<class K>
+    size_t count(K const& k) const // throw()
+    {
+        return this->contains(k);
+    }
+
+    template<class K>
+    bool contains(K const& k) const // throw()
+    {
+        key const kk(k);
+        return npos != this->find_index(kk, kk.hash());
+    }
+
+    std::pair<iterator, bool> insert(value_type const& value) // throw(std::bad_alloc)
+    {
+        key const k(KeyOfT::get(value));
+        size_t const hash(k.hash());
+        size_t const index(this->find_index(k, hash));
+        if(npos != index)
+            return std::make_pair(iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_), false);
+        return std::make_pair(this->insert_unique(hash, value), true);
+    }
+
+    void erase(iterator i) // throw()
+    {
+        this->erase_index(i.slot_ - slots_);
+    }
+
+    template<class K>
+    size_t erase(K const& k) // throw()
+    {
+        key const kk(k);
+        size_t const index(this->find_index(kk, kk.hash()));
+        if(npos == index)
+            return 0;
+        this->erase_index(index);
+        return 1;
+    }
+
+    void clear() // throw()
+    {
+        for(size_t i(0); i != capacity_; ++i)
+        {
+            if(!(ctrl_[i] & 0x80))
+                slots_[i].~value_type();
+            ctrl_[i] = ctrl_empty;
+        }
+        size_ = 0;
+        free_ = this->max_load(capacity_);
+    }
+
+    void reserve(size_t n) // throw(std::bad_alloc, std::length_error)
+    {
+        size_t capacity(group_width);
+        while(this->max_load(capacity) < n)
+        {
+            if(capacity > this->max_size() / 2)
+                throw std::length_error("const_string hash table");
+            capacity *= 2;
+        }
+        if(capacity > capacity_)
+            this->rehash(capacity);
+    }
+
+    void swap(flat_table& other) // throw()
+    {
+        std::swap(static_cast<allocator&>(*this), static_cast<allocator&>(other));
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(free_, other.free_);
+    }
+
+protected:
+    // the key is copied into the table only when it is not found
+    template<class K>
+    std::pair<iterator, bool> emplace_key(K const& k) // throw(std::bad_alloc)
+    {
+        key const kk(k);
+        size_t const hash(kk.hash());
+        size_t const index(this->find_index(kk, hash));
+        if(npos != index)
+            return std::make_pair(iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_), false);
+        return std::make_pair(this->insert_unique(hash, KeyOfT::make(key::make(k, kk))), true);
+    }
+
+private:
+    static size_t const npos = static_cast<size_t>(-1);
+
+    size_t max_size() const { return static_cast<size_t>(-1) / sizeof(value_type) / 2; } // throw()
+    static size_t max_load(size_t capacity) { return capacity - capacity / 8; } // throw()
+
+    template<class I>
+    I make_iterator(size_t index) const // throw()
+    {
+        I i(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+        i.skip_free();
+        return i;
+    }
+
+    static unsigned char h2(size_t hash) { return static_cast<unsigned char>(hash & 0x7f); } // throw()
+    static size_t h1(size_t hash) { return hash >> 7; } // throw()
+
+    size_t find_index(key const& k, size_t hash) const // throw()
+    {
+        if(!capacity_)
+            return npos;
+
+        size_t const mask(capacity_ / group_width - 1);
+        unsigned char const tag(h2(hash));
+        for(size_t group(h1(hash) & mask), step(0); true; group = (group + ++step) & mask)
+        {
+            unsigned char const* const g(ctrl_ + group * group_width);
+            for(unsigned m(cs::aux::group_match(g, tag)); m; m &= m - 1)
+            {
+                size_t const index(group * group_width + cs::aux::lowest_bit(m));
+                if(k.equals(KeyOfT::get(slots_[index])))
+                    return index;
+            }
+            if(cs::aux::group_match(g, ctrl_empty))
+                return npos;
+        }
+    }
+
+    // the first empty or deleted slot of the probe sequence
+    size_t free_index(size_t hash) const // throw()
+    {
+        size_t const mask(capacity_ / group_width - 1);
+        for(size_t group(h1(hash) & mask), step(0); true; group = (group + ++step) & mask)
+        {
+            unsigned char const* const g(ctrl_ + group * group_width);
+            if(unsigned const m = cs::aux::group_match_high(g))
+                return group * group_width + cs::aux::lowest_bit(m);
+        }
+    }
+
+    template<class K>
+    iterator insert_unique(size_t hash, K const& value) // throw(std::bad_alloc)
+    {
+        if(!free_)
+            this->rehash(capacity_ && size_ < this->max_load(capacity_) / 2 ? capacity_ : std::max<size_t>(2 * capacity_, group_width));
+
+        size_t const index(this->free_index(hash));
+        new (slots_ + index) value_type(value);
+        // reusing a deleted slot doesn't consume a free one
+        free_ -= ctrl_empty == ctrl_[index];
+        ctrl_[index] = h2(hash);
+        ++size_;
+        return iterator(ctrl_ + index, slots_ + index, ctrl_ + capacity_);
+    }
+
+    void erase_index(size_t index) // throw()
+    {
+        slots_[index].~value_type();
+        --size_;
+        // no probe sequence went past a group with an empty slot, so that the slot can become empty
+        unsigned char* const g(ctrl_ + index / group_width * group_width);
+        if(cs::aux::group_match(g, ctrl_empty))
+        {
+            ctrl_[index] = ctrl_empty;
+            ++free_;
+        }
+        else
+            ctrl_[index] = ctrl_deleted;
+    }
+
+    void rehash(size_t capacity) // throw(std::bad_alloc)
+    {
+        typedef cs::is_trivially_relocatable<value_type> relocatable;
+        flat_table t(static_cast<allocator const&>(*this), capacity);
+        for(size_t i(0); i != capacity_; ++i)
+        {
+            if(ctrl_[i] & 0x80)
+                continue;
+            size_t const hash(key(KeyOfT::get(slots_[i])).hash());
+            size_t const index(t.free_index(hash));
+            this->move_slot(t.slots_ + index, slots_ + i, relocatable());
+            t.ctrl_[index] = h2(hash);
+            ++t.size_;
+            --t.free_;
+            if(relocatable::value)
+                ctrl_[i] = ctrl_empty;
+        }
+        if(relocatable::value)
+            size_ = 0;
+        // t destroys the old elements that have been copied rather than relocated
+        this->swap(t);
+    }
+
+    static void move_slot(value_type* to, value_type* from, boost::true_type) // throw()
+    {
+        cs::relocate(from, from + 1, to);
+    }
+
+    static void move_slot(value_type* to, value_type* from, boost::false_type) // throw(std::bad_alloc)
+    {
+        new (to) value_type(*from);
+    }
+
+    flat_table(allocator const& a, size_t capacity) // throw(std::bad_alloc)
+        : allocator(a)
+        , ctrl_(0)
+        , slots_(0)
+        , capacity_(0)
+        , size_(0)
+        , free_(0)
+    {
+        ctrl_allocator ca(a);
+        ctrl_ = ca.allocate(capacity);
+        try
+        {
+            slots_ = this->allocator::allocate(capacity);
+        }
+        catch(...)
+        {
+            ca.deallocate(ctrl_, capacity);
+            throw;
+        }
+        std::uninitialized_fill(ctrl_, ctrl_ + capacity, static_cast<unsigned char>(ctrl_empty));
+        capacity_ = capacity;
+        free_ = this->max_load(capacity);
+    }
+
+    void destroy() // throw()
+    {
+        if(capacity_)
+        {
+            this->clear();
+            ctrl_allocator(static_cast<allocator const&>(*this)).deallocate(ctrl_, capacity_);
+            this->allocator::deallocate(slots_, capacity_);
+        }
+    }
+
+private:
+    unsigned char* ctrl_;
+    value_type* slots_;
+    size_t capacity_;
+    size_t size_;
+    size_t free_; // empty slots left before the load factor is exceeded
+};
+
+template<class StringT>
+struct set_key_of
+{
+    static StringT const& get(StringT const& value) { return value; } // throw()
+    static StringT const& make(StringT const& k) { return k; } // throw()
+};
+
+template<class StringT, class V>
+struct map_key_of
+{
+    static StringT const& get(std::pair<StringT const, V> const& value) { return value.first; } // throw()
+    static std::pair<StringT const, V> make(StringT const& k) { return std::pair<StringT const, V>(k, V()); }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Lookups accept const_string, its ref_substr(), char_type const*, std::basic_string<>,
+// std::basic_string_view<> and const_string_literal<> with its precomputed hash.
+
+template<
+      class StringT = const_string<char>
+    , class AllocatorT = std::allocator<StringT>
+    >
+class const_string_set
+    : public cs::aux::flat_table<StringT, StringT, cs::aux::set_key_of<StringT>, AllocatorT>
+{
+private:
+    typedef cs::aux::flat_table<StringT, StringT, cs::aux::set_key_of<StringT>, AllocatorT> base;
+
+public:
+    typedef typename base::iterator iterator;
+
+    // inserts a copy of the key made from any type a lookup accepts
+    template<class K>
+    std::pair<iterator, bool> insert_key(K const& k) // throw(std::bad_alloc)
+    {
+        return this->emplace_key(k);
+    }
+};
+
+template<
+      class V
+    , class StringT = const_string<char>
+    , class AllocatorT = std::allocator<std::pair<StringT const, V> >
+    >
+class const_string_map
+    : public cs::aux::flat_table<StringT, std::pair<StringT const, V>, cs::aux::map_key_of<StringT, V>, AllocatorT>
+{
+private:
+    typedef cs::aux::flat_table<StringT, std::pair<StringT const, V>, cs::aux::map_key_of<StringT, V>, AllocatorT> base;
+
+public:
+    typedef V mapped_type;
+    typedef typename base::value_type value_type;
+    typedef typename base::iterator iterator;
+    typedef typename base::const_iterator const_iterator;
+
+public:
+    // the key is copied into the map only when it is not found
+    template<class K>
+    V& operator[](K const& k) // throw(std::bad_alloc)
+    {
+        return this->emplace_key(k).first->second;
+    }
+
+    template<class K>
+    V& at(K const& k) // throw(std::out_of_range)
+    {
+        iterator const i(this->find(k));
+        if(i == this->end())
+            throw std::out_of_range("const_string_map");
+        return i->second;
+    }
+
+    template<class K>
+    V const& at(K const& k) const // throw(std::out_of_range)
+    {
+        const_iterator const i(this->find(k));
+        if(i == this->end())
+            throw std::out_of_range("const_string_map");
+        return i->second;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_HASH_MAP_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
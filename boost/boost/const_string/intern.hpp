@@ -0,0 +1,346 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// intern.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_INTERN_HPP
+#define BOOST_CONST_STRING_INTERN_HPP
+
+#include "boost/config.hpp"
+
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_HDR_MUTEX) \
+    && !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/detail/key.hpp"
+#include "boost/const_string/detail/epoch.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A set of canonical strings that many threads intern concurrently, e.g. the label values
+// of a metrics store: equal strings interned anywhere share one block.
+//
+// The set is split into shards by hash. A shard is an open addressing table of pointers
+// to immutable entries, which lookups probe with no lock. Only the insertion of a new string
+// locks its shard. A lookup registers the thread in one of the reader counters the threads
+// are spread over, so that the read path writes no memory shared by all the threads,
+// except for the reference counter of the string returned, as any copy of it does,
+// and the used flag of an entry the first time it is looked up after a collect().
+//
+// collect() forgets the strings not interned since the previous collect(). The entries and
+// tables removed are freed once the lookups that could still see them are over: collect()
+// moves the readers on to the next epoch and waits for the readers of the previous one.
+// Strings handed out outlive their entries, as they share the blocks.
+
+template<class StringT = const_string<char> >
+class concurrent_intern_table
+{
+public:
+    typedef StringT value_type;
+    typedef cs::aux::string_key<StringT> key;
+
+private:
+    struct entry
+    {
+        size_t hash;
+        StringT str;
+        std::atomic<bool> used;
+
+        entry() // throw()
+            : hash(0)
+            , used(false)
+        {}
+
+        entry(size_t h, StringT const& s) // throw()
+            : hash(h)
+            , str(s)
+            , used(true)
+        {}
+    };
+
+    struct table
+    {
+        size_t mask;
+        std::atomic<entry*>* slots;
+
+        explicit table(size_t capacity) // throw(std::bad_alloc)
+            : mask(capacity - 1)
+            , slots(new std::atomic<entry*>[capacity])
+        {
+            for(size_t i(0); i != capacity; ++i)
+                slots[i].store(0, std::memory_order_relaxed);
+        }
+
+        ~table()
+        {
+            delete[] slots;
+        }
+    };
+
+    enum { cache_line = 64 };
+
+    struct shard
+    {
+        std::mutex lock;
+        std::atomic<table*> current;
+        std::atomic<size_t> size;
+        size_t occupied; // the slots holding entries or tombstones
+        std::vector<table*> retired; // tables replaced by larger ones
+        char padding[cache_line];
+
+        shard() // throw()
+            : current(0)
+            , size(0)
+            , occupied(0)
+        {}
+    };
+
+    typedef cs::aux::epoch<64> epoch;
+
+    enum { min_capacity = 16 };
+
+public:
+    // the number of shards is rounded up to a power of 2
+    explicit concurrent_intern_table(size_t shards = 64) // throw(std::bad_alloc)
+        : shard_mask_(this->round_up(shards) - 1)
+        , shards_(new shard[shard_mask_ + 1])
+    {}
+
+    ~concurrent_intern_table()
+    {
+        for(size_t i(0); i != shard_mask_ + 1; ++i)
+        {
+            shard& s(shards_[i]);
+            if(table* const t = s.current.load())
+            {
+                for(size_t j(0); j != t->mask + 1; ++j)
+                {
+                    entry* const e(t->slots[j].load());
+                    if(e && e != &tombstone_)
+                        delete e;
+                }
+                delete t;
+            }
+            this->free(s.retired);
+        }
+        delete[] shards_;
+    }
+
+public:
+    // the canonical copy of a string of any type string_key<> accepts, a string interned
+    // for the first time is stored in the table sharing the block of a const StringT argument,
+    // the characters of a reference such as boost::cref() makes are copied
+    template<class K>
+    StringT get_or_insert(K const& k) // throw(std::bad_alloc)
+    {
+        key const kk(k);
+        size_t const hash(kk.hash());
+        shard& s(shards_[hash & shard_mask_]);
+        {
+            typename epoch::reader const r(readers_);
+            entry* const e(this->find(s.current.load(std::memory_order_acquire), kk, hash));
+            if(e && this->mark_used(e, s, kk))
+                return e->str;
+        }
+
+        std::lock_guard<std::mutex> lock(s.lock);
+        table* t(s.current.load(std::memory_order_relaxed));
+        if(entry* const e = this->find(t, kk, hash))
+        {
+            e->used.store(true, std::memory_order_relaxed);
+            return e->str;
+        }
+
+        if(!t || 4 * (s.occupied + 1) > 3 * (t->mask + 1))
+            t = this->grow(s);
+        entry* const e(new entry(hash, key::make(k, kk)));
+        for(size_t i(this->index(hash) & t->mask); true; i = (i + 1) & t->mask)
+        {
+            entry* const x(t->slots[i].load(std::memory_order_relaxed));
+            if(!x || x == &tombstone_)
+            {
+                s.occupied += !x;
+                t->slots[i].store(e, std::memory_order_release);
+                break;
+            }
+        }
+        s.size.fetch_add(1, std::memory_order_relaxed);
+        return e->str;
+    }
+
+    // the number of strings in the table, exact when no thread changes it
+    size_t size() const // throw()
+    {
+        size_t n(0);
+        for(size_t i(0); i != shard_mask_ + 1; ++i)
+            n += shards_[i].size.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    // forgets the strings not interned since the previous call and frees the memory
+    // no lookup uses any more, returns the number of strings forgotten
+    size_t collect() // throw(std::bad_alloc)
+    {
+        std::vector<entry*> entries;
+        std::vector<table*> tables;
+        std::vector<size_t> slots; // of the entries of a shard removed
+        for(size_t i(0); i != shard_mask_ + 1; ++i)
+        {
+            shard& s(shards_[i]);
+            std::lock_guard<std::mutex> lock(s.lock);
+            if(table* const t = s.current.load(std::memory_order_relaxed))
+            {
+                size_t const first(entries.size());
+                slots.clear();
+                for(size_t j(0); j != t->mask + 1; ++j)
+                {
+                    entry* const e(t->slots[j].load(std::memory_order_relaxed));
+                    if(!e || e == &tombstone_)
+                        continue;
+                    if(e->used.load(std::memory_order_relaxed))
+                        e->used.store(false, std::memory_order_relaxed);
+                    else
+                    {
+                        entries.push_back(e);
+                        slots.push_back(j);
+                        t->slots[j].store(&tombstone_, std::memory_order_release);
+                    }
+                }
+
+                // an entry a lookup marked used after the flag was read above is put back,
+                // as the lookup may have missed the removal, see mark_used()
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                size_t removed(first);
+                for(size_t j(0); j != slots.size(); ++j)
+                {
+                    entry* const e(entries[first + j]);
+                    if(e->used.load(std::memory_order_relaxed))
+                        t->slots[slots[j]].store(e, std::memory_order_release);
+                    else
+                        entries[removed++] = e;
+                }
+                entries.resize(removed);
+                s.size.fetch_sub(removed - first, std::memory_order_relaxed);
+            }
+            tables.insert(tables.end(), s.retired.begin(), s.retired.end());
+            s.retired.clear();
+        }
+
+        readers_.synchronize();
+        for(size_t i(0); i != entries.size(); ++i)
+            delete entries[i];
+        this->free(tables);
+        return entries.size();
+    }
+
+private:
+    entry* find(table const* t, key const& k, size_t hash) const // throw()
+    {
+        if(!t)
+            return 0;
+        for(size_t i(this->index(hash) & t->mask); true; i = (i + 1) & t->mask)
+        {
+            entry* const e(t->slots[i].load(std::memory_order_acquire));
+            if(!e)
+                return 0;
+            if(e != &tombstone_ && e->hash == hash && k.equals(e->str))
+                return e;
+        }
+    }
+
+    // marks an entry a lookup found with no lock used, false when a collect() that read
+    // the flag before may have removed the entry, the lookup is then done under the shard lock.
+    // Either the lookup sees the removal here or collect() sees the flag after the removal
+    // and puts the entry back, as both have a fence between their store and load
+    bool mark_used(entry* e, shard const& s, key const& k) const // throw()
+    {
+        if(e->used.load(std::memory_order_relaxed))
+            return true;
+        e->used.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return e == this->find(s.current.load(std::memory_order_acquire), k, e->hash);
+    }
+
+    // the shard lock is held, the tombstones are left behind
+    table* grow(shard& s) // throw(std::bad_alloc)
+    {
+        size_t const size(s.size.load(std::memory_order_relaxed));
+        size_t capacity(min_capacity);
+        while(3 * capacity < 8 * (size + 1))
+            capacity *= 2;
+
+        table* const old(s.current.load(std::memory_order_relaxed));
+        if(old)
+            s.retired.reserve(s.retired.size() + 1);
+        table* const t(new table(capacity));
+        if(old)
+            for(size_t j(0); j != old->mask + 1; ++j)
+            {
+                entry* const e(old->slots[j].load(std::memory_order_relaxed));
+                if(!e || e == &tombstone_)
+                    continue;
+                size_t i(this->index(e->hash) & t->mask);
+                while(t->slots[i].load(std::memory_order_relaxed))
+                    i = (i + 1) & t->mask;
+                t->slots[i].store(e, std::memory_order_relaxed);
+            }
+        s.current.store(t, std::memory_order_release);
+        s.occupied = size;
+        if(old)
+            s.retired.push_back(old); // can't throw, the capacity is reserved
+        return t;
+    }
+
+    size_t index(size_t hash) const // throw(), the bits above those picking the shard
+    {
+        return hash / (shard_mask_ + 1);
+    }
+
+    static void free(std::vector<table*>& tables) // throw()
+    {
+        for(size_t i(0); i != tables.size(); ++i)
+            delete tables[i];
+        tables.clear();
+    }
+
+    static size_t round_up(size_t n) // throw()
+    {
+        size_t r(1);
+        while(r < n)
+            r *= 2;
+        return r;
+    }
+
+private:
+    concurrent_intern_table(concurrent_intern_table const&);
+    concurrent_intern_table& operator=(concurrent_intern_table const&);
+
+private:
+    epoch readers_; // first, so that shards_ isn't leaked when it throws
+    size_t const shard_mask_;
+    shard* const shards_;
+    entry tombstone_; // marks the slots of removed entries, the probes go on past them
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_NO_CXX11_HDR_ATOMIC
+
+#endif // BOOST_CONST_STRING_INTERN_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
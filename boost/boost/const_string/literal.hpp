@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// literal.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_LITERAL_HPP
+#define BOOST_CONST_STRING_LITERAL_HPP
+
+#include "boost/config.hpp"
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/hash.hpp"
+
+#if defined(BOOST_NO_CXX14_CONSTEXPR) || defined(BOOST_NO_CXX11_USER_DEFINED_LITERALS)
+#   define BOOST_CONST_STRING_NO_LITERALS
+#endif
+
+#ifndef BOOST_CONST_STRING_NO_LITERALS
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A string literal with its size and hash computed at compile time.
+//
+// It is a literal type, so that tables of them and static constants are initialized
+// with no code run at startup. It converts to any const_string of the same character type
+// referring to the literal, which takes neither memory allocation nor traits_type::length().
+
+template<class CharT, class TraitsT = std::char_traits<CharT> >
+class const_string_literal
+{
+public:
+    typedef CharT value_type;
+    typedef CharT char_type;
+    typedef TraitsT traits_type;
+
+    typedef size_t size_type;
+    typedef char_type const* const_pointer;
+    typedef char_type const* const_iterator;
+
+public:
+    constexpr const_string_literal(char_type const* s, size_t n) // throw()
+        : data_(s)
+        , size_(n)
+        , hash_(cs::aux::hash_chars(s, n))
+    {}
+
+    template<size_t N>
+    constexpr const_string_literal(char_type const(&literal)[N]) // throw()
+        : data_(literal)
+        , size_(N - 1)
+        , hash_(cs::aux::hash_chars(literal, N - 1))
+    {}
+
+public:
+    constexpr const_iterator begin() const { return data_; } // throw()
+    constexpr const_iterator end() const { return data_ + size_; } // throw()
+    constexpr char_type const* data() const { return data_; } // throw()
+    constexpr char_type const* c_str() const { return data_; } // throw()
+    constexpr size_t size() const { return size_; } // throw()
+    constexpr size_t length() const { return size_; } // throw()
+    constexpr bool empty() const { return !size_; } // throw()
+    constexpr size_t hash() const { return hash_; } // throw()
+
+    constexpr char_type operator[](size_t index) const // throw()
+    {
+        return index < size_ ? data_[index] : char_type();
+    }
+
+public:
+    template<class S>
+    operator const_string<char_type, traits_type, S>() const // throw(std::length_error)
+    {
+        return const_string<char_type, traits_type, S>(S(data_, size_, true)); // a literal has the trailing zero
+    }
+
+    const_string<char_type, traits_type> str() const // throw()
+    {
+        return *this;
+    }
+
+private:
+    char_type const* data_;
+    size_t size_;
+    size_t hash_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class CharT, class TraitsT>
+inline constexpr size_t hash_value(const_string_literal<CharT, TraitsT> const& s) // throw()
+{
+    return s.hash();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define CONST_STRING_DEFINE_COMPARISON(op) \
+template<class T1, class T2, class T3> \
+inline bool operator op(const_string<T1, T2, T3> const& a, const_string_literal<T1, T2> const& b) \
+{ \
+    typedef const_string<T1, T2, T3> string; \
+    return a op string(b); \
+} \
+template<class T1, class T2, class T3> \
+inline bool operator op(const_string_literal<T1, T2> const& a, const_string<T1, T2, T3> const& b) \
+{ \
+    typedef const_string<T1, T2, T3> string; \
+    return string(a) op b; \
+}
+
+CONST_STRING_DEFINE_COMPARISON(==)
+CONST_STRING_DEFINE_COMPARISON(!=)
+CONST_STRING_DEFINE_COMPARISON(<)
+CONST_STRING_DEFINE_COMPARISON(<=)
+CONST_STRING_DEFINE_COMPARISON(>)
+CONST_STRING_DEFINE_COMPARISON(>=)
+
+#undef CONST_STRING_DEFINE_COMPARISON
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// using namespace boost::cs::literals; to use "abc"_cs
+
+namespace cs {
+namespace literals {
+
+inline constexpr const_string_literal<char> operator"" _cs(char const* s, size_t n) // throw()
+{
+    return const_string_literal<char>(s, n);
+}
+
+#ifndef BOOST_NO_CWCHAR
+
+inline constexpr const_string_literal<wchar_t> operator"" _cs(wchar_t const* s, size_t n) // throw()
+{
+    return const_string_literal<wchar_t>(s, n);
+}
+
+#endif // BOOST_NO_CWCHAR
+
+} // namespace literals {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_NO_LITERALS
+
+#endif // BOOST_CONST_STRING_LITERAL_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,291 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// multi_pattern.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_MULTI_PATTERN_HPP
+#define BOOST_CONST_STRING_MULTI_PATTERN_HPP
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "boost/cstdint.hpp"
+
+#include "boost/const_string/const_string.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Finds the occurrences of any of a set of patterns in one pass over a haystack,
+// e.g. of thousands of keywords of a content filter in a message.
+//
+// The patterns are compiled into an Aho-Corasick automaton turned into a DFA: every state has
+// a transition for every character, so that the scan does one table lookup per character
+// and never follows failure links. The characters that occur in no pattern share one class,
+// the table has a column per class rather than per character, so that it stays small
+// for a set of words: 5000 keywords of lowercase letters make some 30000 states of 27 columns.
+//
+// The matches are reported as (pattern, position) in the order their ends occur in the haystack,
+// the longer patterns ending at the same character first. They may overlap. Characters compare
+// by value, the traits_type::eq() of case insensitive traits is not honoured. An empty pattern
+// matches nowhere.
+//
+//     multi_pattern_matcher<> const filter(keywords.begin(), keywords.end());
+//     if(filter.contains(message))
+//         ...
+
+template<class StringT = const_string<char> >
+class multi_pattern_matcher
+{
+public:
+    typedef StringT value_type;
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::traits_type traits_type;
+
+    struct match
+    {
+        size_t pattern; // the index in the range the matcher was made of
+        size_t position; // of the first character in the haystack
+    };
+
+private:
+    typedef boost::uint32_t state_type;
+    typedef std::pair<unsigned long, state_type> wide_class;
+
+    enum { byte_classes = 256 };
+
+public:
+    // the patterns are a range of strings
+    template<class Iterator>
+    multi_pattern_matcher(Iterator first, Iterator last) // throw(std::bad_alloc, std::length_error)
+        : classes_(1)
+    {
+        std::fill(byte_class_, byte_class_ + byte_classes, 0);
+        std::vector<StringT> patterns(first, last);
+        this->make_classes(patterns);
+        this->make_trie(patterns);
+        this->make_dfa();
+    }
+
+public:
+    size_t patterns() const { return sizes_.size(); } // throw()
+    size_t states() const { return match_.size(); } // throw()
+
+    // whether any pattern occurs in the haystack, the scan stops at the first match
+    bool contains(StringT const& haystack) const // throw()
+    {
+        any f = { false };
+        this->scan(haystack, f);
+        return f.found;
+    }
+
+    // writes every match to out
+    template<class OutputIterator>
+    OutputIterator find_all(StringT const& haystack, OutputIterator out) const // throw(...) what *out = throws
+    {
+        collect<OutputIterator> f = { out };
+        this->scan(haystack, f);
+        return f.out;
+    }
+
+    size_t count(StringT const& haystack) const // throw()
+    {
+        counter f = { 0 };
+        this->scan(haystack, f);
+        return f.n;
+    }
+
+    // calls f(pattern, position) for every match, while it returns true
+    template<class F>
+    void for_each_match(StringT const& haystack, F f) const // throw(...) what f throws
+    {
+        this->scan(haystack, f);
+    }
+
+private:
+    struct any
+    {
+        bool found;
+        bool operator()(size_t, size_t) { found = true; return false; }
+    };
+
+    template<class OutputIterator>
+    struct collect
+    {
+        OutputIterator out;
+        bool operator()(size_t pattern, size_t position)
+        {
+            match const m = { pattern, position };
+            *out = m;
+            ++out;
+            return true;
+        }
+    };
+
+    struct counter
+    {
+        size_t n;
+        bool operator()(size_t, size_t) { ++n; return true; }
+    };
+
+    template<class F>
+    void scan(StringT const& haystack, F& f) const
+    {
+        char_type const* const data(haystack.data());
+        size_t const size(haystack.size());
+        state_type const* const next(&next_[0]);
+        state_type s(0);
+        for(size_t i(0); i != size; ++i)
+        {
+            s = next[s * classes_ + this->class_of(data[i])];
+            if(match_[s] && !this->report(s, i, f))
+                return;
+        }
+    }
+
+    // the patterns ending at the character at end in state s and its dictionary suffixes
+    template<class F>
+    bool report(state_type s, size_t end, F& f) const
+    {
+        for(; s; s = dictionary_[s])
+            for(state_type i(outputs_[s]); i != outputs_[s + 1]; ++i)
+                if(!f(output_[i], end + 1 - sizes_[output_[i]]))
+                    return false;
+        return true;
+    }
+
+    static unsigned long value(char_type c) // throw()
+    {
+        return static_cast<unsigned long>(traits_type::to_int_type(c));
+    }
+
+    state_type class_of(char_type c) const // throw()
+    {
+        unsigned long const v(value(c));
+        if(sizeof(char_type) == 1 || v < byte_classes)
+            return byte_class_[v];
+        typename std::vector<wide_class>::const_iterator const i(
+            std::lower_bound(wide_class_.begin(), wide_class_.end(), wide_class(v, 0)));
+        return i != wide_class_.end() && i->first == v ? i->second : 0;
+    }
+
+    // a class for every character of the patterns, 0 for the rest
+    void make_classes(std::vector<StringT> const& patterns) // throw(std::bad_alloc)
+    {
+        for(size_t p(0); p != patterns.size(); ++p)
+            for(size_t i(0); i != patterns[p].size(); ++i)
+            {
+                unsigned long const v(value(patterns[p][i]));
+                if(sizeof(char_type) == 1 || v < byte_classes)
+                {
+                    if(!byte_class_[v])
+                        byte_class_[v] = classes_++;
+                }
+                else if(!this->class_of(patterns[p][i]))
+                    wide_class_.insert(std::lower_bound(wide_class_.begin(), wide_class_.end(), wide_class(v, 0)), wide_class(v, classes_++));
+            }
+    }
+
+    // the trie of the patterns, a missing transition is 0, the root
+    void make_trie(std::vector<StringT> const& patterns) // throw(std::bad_alloc, std::length_error)
+    {
+        std::vector<state_type> ends;
+        next_.assign(classes_, 0);
+        for(size_t p(0); p != patterns.size(); ++p)
+        {
+            state_type s(0);
+            for(size_t i(0); i != patterns[p].size(); ++i)
+            {
+                state_type& t(next_[s * classes_ + this->class_of(patterns[p][i])]);
+                if(!t)
+                {
+                    size_t const states(next_.size() / classes_);
+                    if(states > static_cast<state_type>(-1) / classes_)
+                        throw std::length_error("multi_pattern_matcher: too many states");
+                    t = static_cast<state_type>(states);
+                    next_.resize(next_.size() + classes_); // t is invalidated
+                }
+                s = next_[s * classes_ + this->class_of(patterns[p][i])];
+            }
+            ends.push_back(s);
+            sizes_.push_back(patterns[p].size());
+        }
+
+        // the patterns of every state, an empty pattern ends at the root and is left out
+        size_t const states(next_.size() / classes_);
+        outputs_.assign(states + 1, 0);
+        for(size_t p(0); p != ends.size(); ++p)
+            if(ends[p])
+                ++outputs_[ends[p] + 1];
+        for(size_t s(0); s != states; ++s)
+            outputs_[s + 1] += outputs_[s];
+        output_.resize(outputs_[states]);
+        std::vector<state_type> fill(outputs_.begin(), outputs_.end() - 1);
+        for(size_t p(0); p != ends.size(); ++p)
+            if(ends[p])
+                output_[fill[ends[p]]++] = static_cast<state_type>(p);
+    }
+
+    // breadth first, a missing transition is that of the failure state,
+    // whose transitions are complete by then as it is shallower
+    void make_dfa() // throw(std::bad_alloc)
+    {
+        size_t const states(next_.size() / classes_);
+        std::vector<state_type> failure(states, 0);
+        dictionary_.assign(states, 0);
+        match_.assign(states, 0);
+
+        std::vector<state_type> queue;
+        queue.reserve(states);
+        for(state_type c(0); c != classes_; ++c)
+            if(state_type const t = next_[c])
+                queue.push_back(t);
+        for(size_t q(0); q != queue.size(); ++q)
+        {
+            state_type const s(queue[q]);
+            state_type const f(failure[s]);
+            dictionary_[s] = outputs_[f] != outputs_[f + 1] ? f : dictionary_[f];
+            match_[s] = outputs_[s] != outputs_[s + 1] || dictionary_[s];
+            for(state_type c(0); c != classes_; ++c)
+            {
+                state_type& t(next_[s * classes_ + c]);
+                if(t)
+                {
+                    failure[t] = next_[f * classes_ + c];
+                    queue.push_back(t);
+                }
+                else
+                    t = next_[f * classes_ + c];
+            }
+        }
+    }
+
+private:
+    state_type classes_;
+    state_type byte_class_[byte_classes];
+    std::vector<wide_class> wide_class_; // sorted, for the characters above 255
+    std::vector<state_type> next_; // the transitions, a row of classes_ per state
+    std::vector<char> match_; // whether any pattern ends in a state
+    std::vector<state_type> dictionary_; // the longest proper suffix state where a pattern ends
+    std::vector<state_type> outputs_; // the patterns ending in state s are output_[outputs_[s], outputs_[s + 1])
+    std::vector<state_type> output_;
+    std::vector<size_t> sizes_; // of the patterns
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_MULTI_PATTERN_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,496 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// parallel.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_PARALLEL_HPP
+#define BOOST_CONST_STRING_PARALLEL_HPP
+
+#include "boost/config.hpp"
+
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iterator>
+#include <exception>
+#include <algorithm>
+#include <stdexcept>
+
+#include "boost/type_traits/integral_constant.hpp"
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/search.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+// the number of threads to use for n characters, a thread gets min_chunk of them at least
+inline unsigned parallel_chunks(size_t n, unsigned threads, size_t min_chunk) // throw()
+{
+    if(!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t const most(std::max<size_t>(1, n / std::max<size_t>(1, min_chunk)));
+    return static_cast<unsigned>(std::min<size_t>(threads, most));
+}
+
+// runs f(0) .. f(n - 1) on n threads, f(0) on the calling one,
+// the first exception thrown by f is rethrown once all the threads are done
+template<class F>
+void parallel_for(unsigned n, F const& f) // throw(...) what f throws, std::system_error
+{
+    std::vector<std::exception_ptr> errors(n);
+    struct run
+    {
+        static void chunk(F const* f, unsigned i, std::exception_ptr* error) // throw()
+        {
+            try
+            {
+                (*f)(i);
+            }
+            catch(...)
+            {
+                *error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(n);
+    try
+    {
+        for(unsigned i(1); i < n; ++i)
+            workers.push_back(std::thread(&run::chunk, &f, i, &errors[i]));
+    }
+    catch(...)
+    {
+        for(size_t i(0); i != workers.size(); ++i)
+            workers[i].join();
+        throw;
+    }
+    run::chunk(&f, 0, &errors[0]);
+    for(size_t i(0); i != workers.size(); ++i)
+        workers[i].join();
+
+    for(unsigned i(0); i != n; ++i)
+        if(errors[i])
+            std::rethrow_exception(errors[i]);
+}
+
+// the starts of the occurrences are split into chunks, the chunk of a thread is searched up to
+// the needle size - 1 characters past its end, so that an occurrence across the end is found
+template<class StringT>
+struct parallel_search
+{
+    typedef typename StringT::char_type char_type;
+
+    enum { step = 0x40000 }; // the characters searched between the checks for cancellation
+
+    const_string_searcher<StringT> const* searcher;
+    char_type const* data;
+    size_t size;
+    std::vector<size_t> bounds; // of the chunks, bounds[i] .. bounds[i + 1]
+    std::atomic<size_t>* first; // the first occurrence found so far, the size if none
+    std::vector<size_t>* counts; // of the occurrences in every chunk, 0 when finding
+
+    parallel_search(const_string_searcher<StringT> const& s, StringT const& haystack, size_t pos, unsigned n) // throw(std::bad_alloc)
+        : searcher(&s)
+        , data(haystack.data())
+        , size(haystack.size())
+        , bounds(n + 1)
+        , first(0)
+        , counts(0)
+    {
+        size_t const starts(size - pos);
+        for(unsigned i(0); i != n; ++i)
+            bounds[i] = pos + starts / n * i;
+        bounds[n] = size;
+    }
+
+    void operator()(unsigned i) const // throw()
+    {
+        size_t const m(searcher->needle().size());
+        char_type const* p(data + bounds[i]);
+        char_type const* const last(data + std::min(size, bounds[i + 1] + m - 1));
+        if(counts)
+        {
+            // counted locally, the counts of the chunks share cache lines
+            size_t n(0);
+            for(; (p = searcher->find(p, last)) != last; ++p)
+                ++n;
+            (*counts)[i] = n;
+            return;
+        }
+
+        // a chunk stops when an earlier one has found an occurrence before the characters left
+        while(p != last && static_cast<size_t>(p - data) < first->load(std::memory_order_relaxed))
+        {
+            char_type const* const end(static_cast<size_t>(last - p) > step + m - 1 ? p + step + m - 1 : last);
+            char_type const* const hit(searcher->find(p, end));
+            if(hit != end)
+            {
+                size_t const found(hit - data);
+                size_t current(first->load(std::memory_order_relaxed));
+                while(found < current && !first->compare_exchange_weak(current, found, std::memory_order_relaxed))
+                    ;
+                return;
+            }
+            p = end == last ? last : end - (m - 1);
+        }
+    }
+};
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// The lines of a string, found by several threads at once, e.g. of a log file of gigabytes.
+//
+// The string is cut into one chunk per thread at newlines and every thread finds the lines
+// of its chunk with traits_type::find(), which is memchr() for char. A line is recorded
+// as a slice (owner, pointer, size) of the string, so that no characters are copied.
+//
+// The lines handed out keep the string alive: a line of const_string_storage refers to its
+// characters in place and shares the reference counter of the slices, like the strings of
+// a const_string_table do. Lines short enough to be stored inside a string are copies,
+// and so are the lines of other storages.
+//
+// A line ends before a '\n', which is not a part of it, the last one may have none:
+// "a\n\nb" has the lines "a", "" and "b", "a\n" has only "a".
+//
+//     const_string_lines<> const lines(file, 8);
+//     for(size_t i(0); i != lines.size(); ++i)
+//         parse(lines[i]);
+
+template<class StringT = const_string<char> >
+class const_string_lines
+{
+public:
+    typedef StringT value_type;
+    typedef size_t size_type;
+
+private:
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::traits_type traits_type;
+    typedef typename StringT::storage_type storage_type;
+    typedef cs::aux::external_slice<char_type> slice;
+
+    // the slices are in one vector per chunk, so that the threads never share one
+    struct owner : cs::aux::external_owner
+    {
+        StringT str;
+        std::vector<std::vector<slice> > chunks; // none empty
+        std::vector<size_t> starts; // the index of the first line of every chunk
+
+        explicit owner(StringT const& s) // throw()
+            : cs::aux::external_owner(&owner::destroy, false)
+            , str(s)
+        {}
+
+        static void destroy(cs::aux::external_owner* o) // throw()
+        {
+            delete static_cast<owner*>(o);
+        }
+    };
+
+    // finds the lines of one chunk
+    struct scan
+    {
+        owner* o;
+        std::vector<char_type const*> const* bounds;
+        std::vector<std::vector<slice> >* chunks;
+
+        void operator()(unsigned i) const // throw(std::bad_alloc)
+        {
+            char_type const* first((*bounds)[i]);
+            char_type const* const last((*bounds)[i + 1]);
+            std::vector<slice>& lines((*chunks)[i]);
+            while(first != last)
+            {
+                char_type const* const p(traits_type::find(first, last - first, char_type('\n')));
+                char_type const* const end(p ? p : last);
+                slice const s = { o, first, static_cast<size_t>(end - first) };
+                lines.push_back(s);
+                first = p ? p + 1 : last;
+            }
+        }
+    };
+
+public:
+    class iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef StringT value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef StringT const* pointer;
+        typedef StringT const& reference;
+
+    public:
+        iterator() // throw()
+            : lines_(0)
+            , index_(0)
+        {}
+
+        StringT const& operator*() const { return line_; } // throw()
+        StringT const* operator->() const { return &line_; } // throw()
+
+        iterator& operator++() // throw()
+        {
+            this->seek(index_ + 1);
+            return *this;
+        }
+
+        iterator operator++(int) // throw()
+        {
+            iterator const i(*this);
+            ++*this;
+            return i;
+        }
+
+        friend bool operator==(iterator const& a, iterator const& b) // throw()
+        {
+            return a.index_ == b.index_;
+        }
+
+        friend bool operator!=(iterator const& a, iterator const& b) // throw()
+        {
+            return !(a == b);
+        }
+
+    private:
+        friend class const_string_lines;
+
+        iterator(const_string_lines const* l, size_t index) // throw()
+            : lines_(l)
+            , index_(0)
+        {
+            this->seek(index);
+        }
+
+        void seek(size_t index) // throw()
+        {
+            index_ = index;
+            line_ = index < lines_->size() ? (*lines_)[index] : StringT();
+        }
+
+    private:
+        const_string_lines const* lines_;
+        size_t index_;
+        StringT line_;
+    };
+
+    typedef iterator const_iterator;
+
+public:
+    // threads is the number of threads to use, 0 for one per core, a thread is given
+    // min_chunk characters at least, so that short strings are split on this thread
+    explicit const_string_lines(StringT const& s, unsigned threads = 0, size_t min_chunk = 0x10000) // throw(std::bad_alloc, std::system_error)
+        : owner_(new owner(s))
+    {
+        try
+        {
+            this->split(cs::aux::parallel_chunks(s.size(), threads, min_chunk));
+        }
+        catch(...)
+        {
+            cs::aux::release(owner_);
+            throw;
+        }
+    }
+
+    const_string_lines(const_string_lines const& other) // throw()
+        : owner_(other.owner_)
+    {
+        ++owner_->counter;
+    }
+
+    const_string_lines& operator=(const_string_lines const& other) // throw()
+    {
+        ++other.owner_->counter;
+        cs::aux::release(owner_);
+        owner_ = other.owner_;
+        return *this;
+    }
+
+    ~const_string_lines()
+    {
+        cs::aux::release(owner_);
+    }
+
+public:
+    size_t size() const // throw()
+    {
+        return owner_->starts.empty() ? 0 : owner_->starts.back() + owner_->chunks.back().size();
+    }
+
+    bool empty() const { return owner_->chunks.empty(); } // throw()
+
+    // the string split
+    StringT const& str() const { return owner_->str; } // throw()
+
+    value_type operator[](size_t index) const // throw() for const_string_storage
+    {
+        std::vector<size_t> const& starts(owner_->starts);
+        size_t const chunk(std::upper_bound(starts.begin(), starts.end(), index) - starts.begin() - 1);
+        return make(owner_->chunks[chunk][index - starts[chunk]], cs::aux::can_refer_external<storage_type>());
+    }
+
+    value_type at(size_t index) const // throw(std::out_of_range)
+    {
+        if(index < this->size())
+            return (*this)[index];
+        else
+            throw std::out_of_range("invalid index");
+    }
+
+    iterator begin() const { return iterator(this, 0); } // throw()
+    iterator end() const { return iterator(this, this->size()); } // throw()
+
+private:
+    // cuts the string into n chunks that end after a newline, the last one excepted
+    void split(unsigned n) // throw(std::bad_alloc, std::system_error)
+    {
+        char_type const* const first(owner_->str.data());
+        size_t const size(owner_->str.size());
+        std::vector<char_type const*> bounds(n + 1);
+        bounds[0] = first;
+        bounds[n] = first + size;
+        for(unsigned i(1); i < n; ++i)
+        {
+            char_type const* const from(std::max(bounds[i - 1], first + size / n * i));
+            char_type const* const p(traits_type::find(from, first + size - from, char_type('\n')));
+            bounds[i] = p ? p + 1 : first + size;
+        }
+
+        std::vector<std::vector<slice> > chunks(n);
+        scan const s = { owner_, &bounds, &chunks };
+        cs::aux::parallel_for(n, s);
+
+        size_t lines(0);
+        for(unsigned i(0); i != n; ++i)
+            if(!chunks[i].empty())
+            {
+                owner_->starts.push_back(lines);
+                lines += chunks[i].size();
+                owner_->chunks.push_back(std::vector<slice>());
+                owner_->chunks.back().swap(chunks[i]);
+            }
+    }
+
+    static StringT make(slice const& s, boost::true_type) // throw()
+    {
+        return s.size < storage_type::effective_buffer_size_chars
+            ? StringT(s.data, s.data + s.size)
+            : StringT(storage_type(s))
+            ;
+    }
+
+    static StringT make(slice const& s, boost::false_type) // throw(std::bad_alloc)
+    {
+        return StringT(s.data, s.data + s.size);
+    }
+
+private:
+    owner* owner_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// split_lines_parallel(file) finds the lines of a string on a thread per core.
+
+template<class CharT, class TraitsT, class StorageT>
+inline const_string_lines<const_string<CharT, TraitsT, StorageT> >
+split_lines_parallel(const_string<CharT, TraitsT, StorageT> const& s, unsigned threads = 0, size_t min_chunk = 0x10000) // throw(std::bad_alloc, std::system_error)
+{
+    return const_string_lines<const_string<CharT, TraitsT, StorageT> >(s, threads, min_chunk);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// parallel_find() and parallel_count() search a haystack of hundreds of megabytes, e.g. a dump
+// mapped into memory, on a thread per core, with const_string_searcher<>.
+//
+// parallel_find() returns the position of the first occurrence at or after pos, npos if there
+// is none. Every thread searches its chunk a step at a time and gives up once an occurrence
+// has been found before the rest of its chunk, so that the call returns as soon as the chunks
+// before the first occurrence have been searched.
+//
+// parallel_count() returns the number of occurrences, overlapping ones included,
+// unlike const_string_searcher<>::count(): "aa" occurs 3 times in "aaaa".
+//
+// The threads are started for every call, a thread is given min_chunk characters at least.
+
+template<class CharT, class TraitsT, class StorageT>
+size_t parallel_find(
+      const_string<CharT, TraitsT, StorageT> const& haystack
+    , const_string<CharT, TraitsT, StorageT> const& needle
+    , size_t pos = 0
+    , unsigned threads = 0
+    , size_t min_chunk = 0x100000
+    ) // throw(std::bad_alloc, std::system_error)
+{
+    typedef const_string<CharT, TraitsT, StorageT> string;
+    size_t const size(haystack.size());
+    if(pos > size || needle.size() > size - pos)
+        return string::npos;
+    if(needle.empty())
+        return pos;
+
+    const_string_searcher<string> const searcher(needle);
+    size_t const starts(size - pos - needle.size() + 1);
+    cs::aux::parallel_search<string> search(searcher, haystack, pos, cs::aux::parallel_chunks(starts, threads, min_chunk));
+    std::atomic<size_t> first(size);
+    search.first = &first;
+    cs::aux::parallel_for(static_cast<unsigned>(search.bounds.size() - 1), search);
+    size_t const found(first.load());
+    return found != size ? found : string::npos;
+}
+
+template<class CharT, class TraitsT, class StorageT>
+size_t parallel_count(
+      const_string<CharT, TraitsT, StorageT> const& haystack
+    , const_string<CharT, TraitsT, StorageT> const& needle
+    , unsigned threads = 0
+    , size_t min_chunk = 0x100000
+    ) // throw(std::bad_alloc, std::system_error)
+{
+    typedef const_string<CharT, TraitsT, StorageT> string;
+    size_t const size(haystack.size());
+    if(needle.size() > size)
+        return 0;
+    if(needle.empty())
+        return size + 1;
+
+    const_string_searcher<string> const searcher(needle);
+    unsigned const n(cs::aux::parallel_chunks(size - needle.size() + 1, threads, min_chunk));
+    cs::aux::parallel_search<string> search(searcher, haystack, 0, n);
+    std::vector<size_t> counts(n);
+    search.counts = &counts;
+    cs::aux::parallel_for(n, search);
+    size_t total(0);
+    for(unsigned i(0); i != n; ++i)
+        total += counts[i];
+    return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_NO_CXX11_HDR_THREAD
+
+#endif // BOOST_CONST_STRING_PARALLEL_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,395 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// pool.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_POOL_HPP
+#define BOOST_CONST_STRING_POOL_HPP
+
+#include <new>
+#include <limits>
+#include <cstddef>
+
+#include "boost/config.hpp"
+#include "boost/assert.hpp"
+
+#if !defined(BOOST_NO_CXX11_THREAD_LOCAL) && !defined(BOOST_NO_CXX11_HDR_MUTEX)
+#   define BOOST_CONST_STRING_POOL
+#   include <mutex>
+#   ifndef NDEBUG
+#       include <map>
+#   endif
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+#ifdef BOOST_CONST_STRING_POOL
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Blocks of up to pool_max_size bytes are served from free lists of size classes
+// pool_granularity bytes apart. Every thread keeps its own lists and takes no lock
+// while they are neither empty nor too long. Blocks move between the threads in batches
+// through the central lists: a thread that runs out takes a batch, a thread with too many
+// blocks of a class gives a batch back. So a block freed on another thread than it was
+// allocated on just joins the lists of that thread. A thread returns its blocks
+// to the central lists when it exits, so that they are reused by other threads.
+//
+// Memory of the size classes is taken from ::operator new() in slabs and never returned.
+// A block must be freed with a size of the class it was allocated for, which debug builds
+// assert by looking the block up in the slabs.
+
+enum
+{
+      pool_granularity = 16
+    , pool_max_size = 512
+    , pool_classes = pool_max_size / pool_granularity
+    , pool_batch = 32
+    , pool_slab_size = 64 * 1024
+};
+
+struct pool_block
+{
+    pool_block* next;
+};
+
+inline size_t pool_class(size_t bytes) // throw()
+{
+    return (bytes - 1) / pool_granularity;
+}
+
+// the lists shared by all the threads
+class pool_central
+{
+public:
+    static pool_central& instance() // throw(std::bad_alloc)
+    {
+        // never destroyed, threads may outlive static objects
+        static pool_central* const p(new pool_central);
+        return *p;
+    }
+
+    // a list of up to pool_batch blocks of a class, carves a new slab when there is none
+    pool_block* acquire(size_t cls) // throw(std::bad_alloc)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!lists_[cls])
+            this->carve(cls);
+        pool_block* const first(lists_[cls]);
+        pool_block* last(first);
+        for(size_t n(1); n != pool_batch && last->next; ++n)
+            last = last->next;
+        lists_[cls] = last->next;
+        last->next = 0;
+        return first;
+    }
+
+    void release(size_t cls, pool_block* first, pool_block* last) // throw()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last->next = lists_[cls];
+        lists_[cls] = first;
+    }
+
+#ifndef NDEBUG
+    // the class of the slab a block was carved from, pool_classes for a block of ::operator new()
+    size_t slab_class(void const* p) // throw()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        char const* const c(static_cast<char const*>(p));
+        std::map<char const*, size_t>::const_iterator i(slabs_.upper_bound(c));
+        if(i == slabs_.begin() || c >= (--i)->first + pool_slab_size)
+            return pool_classes;
+        return i->second;
+    }
+#endif
+
+private:
+    pool_central() // throw()
+    {
+        for(size_t i(0); i != pool_classes; ++i)
+            lists_[i] = 0;
+    }
+
+    void carve(size_t cls) // throw(std::bad_alloc)
+    {
+        size_t const size((cls + 1) * pool_granularity);
+        char* const slab(static_cast<char*>(::operator new(pool_slab_size)));
+#ifndef NDEBUG
+        try
+        {
+            slabs_[slab] = cls;
+        }
+        catch(...)
+        {
+            ::operator delete(slab);
+            throw;
+        }
+#endif
+        pool_block* next(0);
+        for(size_t offset((pool_slab_size / size - 1) * size); true; offset -= size)
+        {
+            pool_block* const b(reinterpret_cast<pool_block*>(slab + offset));
+            b->next = next;
+            next = b;
+            if(!offset)
+                break;
+        }
+        lists_[cls] = next;
+    }
+
+private:
+    std::mutex mutex_;
+    pool_block* lists_[pool_classes];
+#ifndef NDEBUG
+    std::map<char const*, size_t> slabs_; // by the first byte
+#endif
+};
+
+// the lists of one thread
+class pool_cache
+{
+public:
+    static pool_cache* current(); // throw(), 0 when the thread's cache has been destroyed
+
+    pool_cache() // throw()
+    {
+        for(size_t i(0); i != pool_classes; ++i)
+        {
+            lists_[i] = 0;
+            counts_[i] = 0;
+        }
+    }
+
+    ~pool_cache()
+    {
+        for(size_t i(0); i != pool_classes; ++i)
+            if(pool_block* const first = lists_[i])
+            {
+                pool_block* last(first);
+                while(last->next)
+                    last = last->next;
+                pool_central::instance().release(i, first, last);
+            }
+    }
+
+    void* allocate(size_t cls) // throw(std::bad_alloc)
+    {
+        if(!lists_[cls])
+        {
+            lists_[cls] = pool_central::instance().acquire(cls);
+            counts_[cls] = 0;
+            for(pool_block* b(lists_[cls]); b; b = b->next)
+                ++counts_[cls];
+        }
+        pool_block* const b(lists_[cls]);
+        lists_[cls] = b->next;
+        --counts_[cls];
+        return b;
+    }
+
+    void deallocate(void* p, size_t cls) // throw()
+    {
+        pool_block* const b(static_cast<pool_block*>(p));
+        b->next = lists_[cls];
+        lists_[cls] = b;
+        if(++counts_[cls] == 2 * pool_batch)
+        {
+            // give the older half back
+            pool_block* last(b);
+            for(size_t n(1); n != pool_batch; ++n)
+                last = last->next;
+            pool_block* const first(last->next);
+            last->next = 0;
+            counts_[cls] = pool_batch;
+            for(last = first; last->next;)
+                last = last->next;
+            pool_central::instance().release(cls, first, last);
+        }
+    }
+
+private:
+    pool_cache(pool_cache const&);
+    pool_cache& operator=(pool_cache const&);
+
+private:
+    pool_block* lists_[pool_classes];
+    size_t counts_[pool_classes];
+};
+
+// the state of the thread's cache, trivially destructible to stay readable after the cache is gone
+enum pool_cache_state { pool_cache_none, pool_cache_alive, pool_cache_destroyed };
+
+inline pool_cache_state& pool_thread_state() // throw()
+{
+    static thread_local pool_cache_state state(pool_cache_none);
+    return state;
+}
+
+struct pool_thread_cache : pool_cache
+{
+    pool_thread_cache() { pool_thread_state() = pool_cache_alive; }
+    ~pool_thread_cache() { pool_thread_state() = pool_cache_destroyed; }
+};
+
+inline pool_cache* pool_cache::current() // throw()
+{
+    if(pool_cache_destroyed == pool_thread_state())
+        return 0;
+    static thread_local pool_thread_cache cache;
+    return &cache;
+}
+
+inline void* pool_allocate(size_t bytes) // throw(std::bad_alloc)
+{
+    if(!bytes || bytes > pool_max_size)
+        return ::operator new(bytes);
+    size_t const cls(pool_class(bytes));
+    if(pool_cache* const cache = pool_cache::current())
+        return cache->allocate(cls);
+    pool_block* const b(pool_central::instance().acquire(cls));
+    if(b->next)
+    {
+        pool_block* last(b->next);
+        while(last->next)
+            last = last->next;
+        pool_central::instance().release(cls, b->next, last);
+    }
+    return b;
+}
+
+inline void pool_deallocate(void* p, size_t bytes) // throw()
+{
+    if(!bytes || bytes > pool_max_size)
+    {
+        BOOST_ASSERT(pool_classes == pool_central::instance().slab_class(p));
+        return ::operator delete(p);
+    }
+    size_t const cls(pool_class(bytes));
+    BOOST_ASSERT(cls == pool_central::instance().slab_class(p));
+    if(pool_cache* const cache = pool_cache::current())
+        return cache->deallocate(p, cls);
+    pool_block* const b(static_cast<pool_block*>(p));
+    b->next = 0;
+    pool_central::instance().release(cls, b, b);
+}
+
+#else // BOOST_CONST_STRING_POOL
+
+// no thread local storage, the pool is the free store
+
+inline void* pool_allocate(size_t bytes) // throw(std::bad_alloc)
+{
+    return ::operator new(bytes);
+}
+
+inline void pool_deallocate(void* p, size_t) // throw()
+{
+    ::operator delete(p);
+}
+
+#endif // BOOST_CONST_STRING_POOL
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A stateless allocator for the shared blocks of const_string of 16 to 512 bytes,
+// served from thread local free lists of size classes. Memory may be freed on any thread.
+//
+//     typedef boost::const_string<char, std::char_traits<char>,
+//         boost::const_string_storage<std::char_traits<char>, boost::const_string_pool_allocator<char> > > pooled;
+//
+// Without thread local storage it allocates from the free store.
+
+template<class T>
+class const_string_pool_allocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef T const* const_pointer;
+    typedef T& reference;
+    typedef T const& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<class U>
+    struct rebind
+    {
+        typedef const_string_pool_allocator<U> other;
+    };
+
+public:
+    const_string_pool_allocator() // throw()
+    {}
+
+    template<class U>
+    const_string_pool_allocator(const_string_pool_allocator<U> const&) // throw()
+    {}
+
+public:
+    pointer allocate(size_type n, void const* = 0) // throw(std::bad_alloc)
+    {
+        if(n > this->max_size())
+            throw std::bad_alloc();
+        return static_cast<pointer>(cs::aux::pool_allocate(n * sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type n) // throw()
+    {
+        cs::aux::pool_deallocate(p, n * sizeof(T));
+    }
+
+    size_type max_size() const // throw()
+    {
+        return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+    pointer address(reference x) const { return &x; } // throw()
+    const_pointer address(const_reference x) const { return &x; } // throw()
+
+    void construct(pointer p, T const& value) // throw(...)
+    {
+        new (static_cast<void*>(p)) T(value);
+    }
+
+    void destroy(pointer p) // throw()
+    {
+        p->~T();
+    }
+};
+
+template<class T, class U>
+inline bool operator==(const_string_pool_allocator<T> const&, const_string_pool_allocator<U> const&) // throw()
+{
+    return true;
+}
+
+template<class T, class U>
+inline bool operator!=(const_string_pool_allocator<T> const&, const_string_pool_allocator<U> const&) // throw()
+{
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_POOL_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
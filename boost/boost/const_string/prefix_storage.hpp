@@ -0,0 +1,364 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// prefix_storage.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_PREFIX_STORAGE_HPP
+#define BOOST_CONST_STRING_PREFIX_STORAGE_HPP
+
+#include <cstring>
+#include <limits>
+#include <new>
+#include <memory>
+#include <stdexcept>
+
+#include "boost/config.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/aligned_storage.hpp"
+#include "boost/detail/atomic_count.hpp"
+#include "boost/type_traits/integral_constant.hpp"
+#include "boost/type_traits/is_empty.hpp"
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/relocatable.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A storage strategy that keeps the first characters of a string next to the pointer.
+//
+// layout (16 bytes with 64-bit pointers):
+//     | 32-bit flags and size | 4-byte prefix | pointer             |
+//     | 32-bit flags and size | up to 12 bytes of inline characters   |
+//
+// The inline characters of a short string start at the prefix, so that the prefix is
+// the beginning of any string. Comparing strings with this storage looks at the prefixes
+// first and follows the pointers only when the prefixes are equal, which for sorting and
+// searching long strings saves a cache miss per comparison. Strings of different sizes
+// are never equal and are told apart by the sizes alone.
+//
+// The strings are no longer than 2^28 - 1 characters. Otherwise it behaves
+// as const_string_storage<>: references, inline copies, shared reference counted copies
+// and immortal copies.
+//
+//     typedef boost::const_string<char, std::char_traits<char>,
+//         boost::const_string_prefix_storage<std::char_traits<char> > > url;
+
+template<
+      class TraitsT
+    , class AllocatorT = std::allocator<typename TraitsT::char_type>
+    >
+class const_string_prefix_storage
+    : private AllocatorT::template rebind<
+          typename cs::aux::aligned_union<boost::detail::atomic_count, typename TraitsT::char_type>::type
+      >::other
+{
+private:
+    typedef TraitsT traits_type;
+    typedef typename TraitsT::char_type char_type;
+    typedef typename AllocatorT::template rebind<
+        typename cs::aux::aligned_union<boost::detail::atomic_count, typename TraitsT::char_type>::type
+    >::other allocator;
+
+    typedef boost::uint32_t state_type;
+    static state_type const shared_bit_mask = state_type(1) << 31;
+    static state_type const allocated_bit_mask = shared_bit_mask >> 1;
+    static state_type const immortal_bit_mask = allocated_bit_mask >> 1;
+    static state_type const terminated_bit_mask = immortal_bit_mask >> 1;
+    static state_type const kind_bit_mask = shared_bit_mask | allocated_bit_mask | immortal_bit_mask;
+    static state_type const flags_bit_mask = kind_bit_mask | terminated_bit_mask;
+    static state_type const size_bit_mask = terminated_bit_mask - 1;
+
+public:
+    enum { prefix_chars = sizeof(char_type) < 4 ? 4 / sizeof(char_type) : 1 };
+    enum { effective_buffer_size_chars =
+          prefix_chars
+        + (sizeof(char_type const*) + sizeof(char_type) - 1) / sizeof(char_type)
+        };
+
+public:
+    const_string_prefix_storage(char_type const* begin, size_t length, int terminated)
+    {
+        if(length > this->max_size())
+            throw std::length_error("const_string: the source string is way too long");
+
+        state_ = static_cast<state_type>(length) | shared_bit_mask | (terminated ? terminated_bit_mask : 0);
+        this->set_pointer(begin);
+        this->seal();
+    }
+
+    const_string_prefix_storage(char_type const* begin, size_t length)
+    {
+        if(length > this->max_size())
+            throw std::length_error("const_string: the source string is way too long");
+
+        state_ = static_cast<state_type>(length)
+            | allocated_bit_mask
+            | terminated_bit_mask
+            | (length > effective_buffer_size_chars - 1 ? shared_bit_mask : 0)
+            ;
+
+        char_type* copy;
+
+        if(this->is_shared())
+        {
+            void* const p(this->allocator::allocate(this->elements(length)));
+            new (p) boost::detail::atomic_count(1);
+            copy = reinterpret_cast<char_type*>(reinterpret_cast<size_t>(p) + sizeof(typename allocator::value_type));
+            this->set_pointer(copy);
+        }
+        else
+        {
+            copy = chars_;
+        }
+
+        if(begin)
+            TraitsT::copy(copy, begin, length);
+
+        copy[length] = char_type();
+
+        if(begin)
+            this->seal();
+    }
+
+    const_string_prefix_storage(const_string_prefix_storage const& other) // throw()
+        : allocator(other)
+        , state_(other.state_)
+    {
+        std::memcpy(chars_, other.chars_, sizeof chars_);
+        if(this->is_counted())
+            ++this->counter();
+    }
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+    const_string_prefix_storage(const_string_prefix_storage&& other) BOOST_NOEXCEPT
+        : allocator(other)
+        , state_(shared_bit_mask | terminated_bit_mask)
+    {
+        this->set_pointer(cs::aux::zero_string_literal<char_type>::value);
+        this->swap(other);
+    }
+
+#endif // BOOST_NO_CXX11_RVALUE_REFERENCES
+
+    const_string_prefix_storage const& operator=(const_string_prefix_storage const& other) // throw()
+    {
+        if(this != &other)
+        {
+            this->allocator::operator=(other);
+            this->reset();
+            new (this) const_string_prefix_storage(other);
+        }
+        return *this;
+    }
+
+    ~const_string_prefix_storage()
+    {
+        this->reset();
+    }
+
+public:
+    void swap(const_string_prefix_storage& other) // throw()
+    {
+        this->swap(other, boost::is_empty<allocator>());
+    }
+
+private:
+    void swap(const_string_prefix_storage& other, boost::true_type) // throw()
+    {
+        boost::aligned_storage<sizeof(const_string_prefix_storage), boost::alignment_of<const_string_prefix_storage>::value> t;
+        std::memcpy(t.address(), static_cast<void*>(this), sizeof(const_string_prefix_storage));
+        std::memcpy(static_cast<void*>(this), static_cast<void*>(&other), sizeof(const_string_prefix_storage));
+        std::memcpy(static_cast<void*>(&other), t.address(), sizeof(const_string_prefix_storage));
+    }
+
+    void swap(const_string_prefix_storage& other, boost::false_type) // throw()
+    {
+        const_string_prefix_storage const t(*this);
+        *this = other;
+        other = t;
+    }
+
+public:
+    // a shared block is freed with the size it was allocated for, so that when the new size
+    // needs fewer elements the characters are moved to a block of the new size
+    const_string_prefix_storage& set_size(size_t length) // throw(std::bad_alloc, std::length_error)
+    {
+        if(length > this->size())
+            throw std::length_error("const_string: the source string is way too long");
+        if(this->is_counted() && this->elements(length) != this->elements(this->size()))
+        {
+            const_string_prefix_storage copy(this->begin(), length);
+            this->swap(copy);
+            return *this;
+        }
+        state_ = (state_ & flags_bit_mask) | static_cast<state_type>(length);
+        this->seal();
+        return *this;
+    }
+
+    // copies the first characters of a shared string next to the pointer
+    void seal() // throw()
+    {
+        if(this->is_shared())
+        {
+            size_t const n(std::min<size_t>(prefix_chars, this->size()));
+            traits_type::copy(chars_, this->pointer(), n);
+            traits_type::assign(chars_ + n, prefix_chars - n, char_type());
+        }
+    }
+
+    void make_immortal() // throw()
+    {
+        if(this->is_counted())
+        {
+            ++this->counter();
+            state_ |= immortal_bit_mask;
+        }
+    }
+
+public:
+    size_t max_size() const
+    {
+        return size_bit_mask;
+    }
+
+    size_t size() const
+    {
+        return state_ & size_bit_mask;
+    }
+
+    char_type const* begin() const
+    {
+        return this->is_shared()
+            ? this->pointer()
+            : chars_
+            ;
+    }
+
+    char_type const* end() const
+    {
+        return this->begin() + this->size();
+    }
+
+    int compare(const_string_prefix_storage const& other) const // throw()
+    {
+        size_t const a_size(this->size());
+        size_t const b_size(other.size());
+        size_t const n(std::min<size_t>(prefix_chars, std::min(a_size, b_size)));
+        if(int const res = traits_type::compare(chars_, other.chars_, n))
+            return res;
+        if(n == a_size || n == b_size)
+            return a_size < b_size ? -1 : a_size != b_size;
+        return cs::aux::compare_chars<traits_type>(this->begin() + n, a_size - n, other.begin() + n, b_size - n);
+    }
+
+    bool is_terminated() const // throw()
+    {
+        return 0 != (state_ & terminated_bit_mask);
+    }
+
+    // whether the characters are neither a copy nor kept alive by an owner
+    bool is_reference() const // throw()
+    {
+        return shared_bit_mask == (state_ & kind_bit_mask);
+    }
+
+private:
+    void reset()
+    {
+        if(this->is_counted())
+        {
+            if(0 == --this->counter())
+            {
+                boost::detail::atomic_count* const p(&this->counter());
+                using boost::detail::atomic_count;
+                p->~atomic_count();
+                this->allocator::deallocate(reinterpret_cast<typename allocator::pointer>(p), this->elements(this->size()));
+            }
+        }
+        state_ = shared_bit_mask;
+        this->set_pointer(0);
+    }
+
+    static size_t elements(size_t length)
+    {
+        size_t const character_bytes((length + 1) * sizeof(char_type));
+        return 1
+            + character_bytes / sizeof(typename allocator::value_type)
+            + (0 != character_bytes % sizeof(typename allocator::value_type))
+            ;
+    }
+
+    bool is_shared() const
+    {
+        return 0 != (state_ & shared_bit_mask);
+    }
+
+    bool is_counted() const
+    {
+        return (allocated_bit_mask | shared_bit_mask) == (state_ & kind_bit_mask);
+    }
+
+    // the storage is aligned for state_type only, so that the pointer is never dereferenced in place
+    char_type const* pointer() const
+    {
+        char_type const* p;
+        std::memcpy(&p, chars_ + prefix_chars, sizeof p);
+        return p;
+    }
+
+    void set_pointer(char_type const* p)
+    {
+        std::memcpy(chars_ + prefix_chars, &p, sizeof p);
+    }
+
+    boost::detail::atomic_count& counter()
+    {
+        return *reinterpret_cast<boost::detail::atomic_count*>(
+            reinterpret_cast<typename allocator::pointer>(
+                const_cast<char_type*>(this->pointer())
+                ) - 1
+            );
+    }
+
+private:
+    state_type state_;
+    char_type chars_[effective_buffer_size_chars];
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class CharT, class TraitsT = std::char_traits<CharT> >
+struct prefix_const_string
+{
+    typedef const_string<CharT, TraitsT, const_string_prefix_storage<TraitsT> > type;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+
+template<class TraitsT, class AllocatorT>
+struct is_trivially_relocatable<const_string_prefix_storage<TraitsT, AllocatorT> >
+    : boost::is_empty<AllocatorT>
+{};
+
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_PREFIX_STORAGE_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
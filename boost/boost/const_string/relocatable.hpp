@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// relocatable.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_RELOCATABLE_HPP
+#define BOOST_CONST_STRING_RELOCATABLE_HPP
+
+#include <cstring>
+#include <utility>
+
+#include "boost/static_assert.hpp"
+#include "boost/type_traits/integral_constant.hpp"
+#include "boost/type_traits/is_empty.hpp"
+#include "boost/type_traits/has_trivial_copy.hpp"
+#include "boost/type_traits/has_trivial_destructor.hpp"
+
+#include "boost/const_string/const_string_fwd.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// An object of a trivially relocatable type can be moved to another address by copying its bytes,
+// the source then is treated as raw memory, its destructor is not called.
+
+template<class T>
+struct is_trivially_relocatable
+    : boost::integral_constant<
+          bool
+        , boost::has_trivial_copy<T>::value && boost::has_trivial_destructor<T>::value
+        >
+{};
+
+// the buffer of const_string_storage<> is never pointed into,
+// an allocator that has state may be, so that only stateless ones are relocated
+template<class TraitsT, class AllocatorT, size_t buffer_size, size_t buffer_alignment>
+struct is_trivially_relocatable<const_string_storage<TraitsT, AllocatorT, buffer_size, buffer_alignment> >
+    : boost::is_empty<AllocatorT>
+{};
+
+template<class CharT, class TraitsT, class StorageT>
+struct is_trivially_relocatable<const_string<CharT, TraitsT, StorageT> >
+    : is_trivially_relocatable<StorageT>
+{};
+
+template<class T, class U>
+struct is_trivially_relocatable<std::pair<T, U> >
+    : boost::integral_constant<
+          bool
+        , is_trivially_relocatable<T>::value && is_trivially_relocatable<U>::value
+        >
+{};
+
+template<class T>
+struct is_trivially_relocatable<T const>
+    : is_trivially_relocatable<T>
+{};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+// moves [first, last) to uninitialized memory at to, the ranges may overlap
+template<class T>
+inline void relocate(T* first, T* last, T* to) // throw()
+{
+    BOOST_STATIC_ASSERT(is_trivially_relocatable<T>::value);
+    if(first != last)
+        std::memmove(static_cast<void*>(to), static_cast<void const*>(first), (last - first) * sizeof(T));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_RELOCATABLE_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,345 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// rope.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_ROPE_HPP
+#define BOOST_CONST_STRING_ROPE_HPP
+
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include "boost/intrusive_ptr.hpp"
+#include "boost/detail/atomic_count.hpp"
+
+#include "boost/const_string/const_string.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// An immutable string made of pieces of strings, e.g. a document a template engine assembles
+// from shared fragments, that is concatenated and sliced without copying the characters.
+//
+// A rope is a balanced binary tree of reference counted nodes, the leaves are slices
+// (string, offset, size) of const_strings, sharing their blocks. A concatenation is
+// a node over the two ropes, rebalanced along one edge of the deeper one as an AVL tree
+// is joined, so that concatenation, substr() and indexing take time logarithmic in the number
+// of leaves, the nodes of the operands are shared by the result and never copied.
+// Two leaves of leaf_merge characters or fewer together are concatenated into one new leaf
+// instead, so that appending many short pieces doesn't make a tree of tiny leaves.
+//
+// Ropes are as thread safe as const_strings: the nodes are never changed once made.
+//
+//     const_rope<> page(header);
+//     page += body.substr(0, 4096);
+//     page.for_each_chunk(writer); // or page.flatten()
+
+template<class StringT = const_string<char> >
+class const_rope
+{
+public:
+    typedef StringT string_type;
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::char_type value_type;
+    typedef typename StringT::traits_type traits_type;
+    typedef typename StringT::storage_type storage_type;
+    typedef size_t size_type;
+
+    static size_t const npos = static_cast<size_t>(-1);
+
+    enum { leaf_merge = 128 };
+
+private:
+    struct node;
+    typedef boost::intrusive_ptr<node> node_ptr;
+
+    // a leaf when depth is 0, a concatenation of left and right otherwise
+    struct node
+    {
+        boost::detail::atomic_count counter;
+        size_t size;
+        unsigned depth;
+        node_ptr left;
+        node_ptr right;
+        StringT str;
+        size_t offset; // of the leaf characters in str
+
+        node(StringT const& s, size_t o, size_t n) // throw()
+            : counter(0)
+            , size(n)
+            , depth(0)
+            , str(s)
+            , offset(o)
+        {}
+
+        node(node_ptr const& l, node_ptr const& r) // throw()
+            : counter(0)
+            , size(l->size + r->size)
+            , depth(1 + std::max(l->depth, r->depth))
+            , left(l)
+            , right(r)
+            , offset(0)
+        {}
+
+        char_type const* data() const { return str.data() + offset; } // throw(), of a leaf
+
+        friend void intrusive_ptr_add_ref(node* p) // throw()
+        {
+            ++p->counter;
+        }
+
+        friend void intrusive_ptr_release(node* p) // throw()
+        {
+            if(0 == --p->counter)
+                delete p;
+        }
+    };
+
+public:
+    const_rope() // throw()
+    {}
+
+    const_rope(StringT const& s) // throw(std::bad_alloc)
+        : root_(s.empty() ? 0 : new node(s, 0, s.size()))
+    {}
+
+public:
+    size_t size() const { return root_ ? root_->size : 0; } // throw()
+    size_t length() const { return this->size(); } // throw()
+    bool empty() const { return !root_; } // throw()
+
+    // the number of concatenations on the longest path to a leaf
+    unsigned depth() const { return root_ ? root_->depth : 0; } // throw()
+
+    char_type operator[](size_t index) const // throw()
+    {
+        node const* p(root_.get());
+        while(p->depth)
+        {
+            if(index < p->left->size)
+                p = p->left.get();
+            else
+            {
+                index -= p->left->size;
+                p = p->right.get();
+            }
+        }
+        return p->data()[index];
+    }
+
+    char_type at(size_t index) const // throw(std::out_of_range)
+    {
+        if(index < this->size())
+            return (*this)[index];
+        else
+            throw std::out_of_range("invalid index");
+    }
+
+    const_rope substr(size_t pos = 0, size_t n = npos) const // throw(std::bad_alloc, std::out_of_range)
+    {
+        size_t const size(this->size());
+        if(pos > size)
+            throw std::out_of_range("invalid pos");
+        n = std::min(n, size - pos);
+        return const_rope(n ? slice(root_, pos, n) : node_ptr());
+    }
+
+    const_rope& append(const_rope const& r) // throw(std::bad_alloc)
+    {
+        root_ = join(root_, r.root_);
+        return *this;
+    }
+
+    const_rope& operator+=(const_rope const& r) // throw(std::bad_alloc)
+    {
+        return this->append(r);
+    }
+
+    void swap(const_rope& other) // throw()
+    {
+        root_.swap(other.root_);
+    }
+
+    void clear() // throw()
+    {
+        root_.reset();
+    }
+
+    // calls f(data, size) for the leaves left to right, e.g. to write them out
+    template<class F>
+    F for_each_chunk(F f) const // throw(...) what f throws
+    {
+        if(root_)
+            visit(root_.get(), f);
+        return f;
+    }
+
+    // the characters in one string, the string itself when the rope is all of one
+    StringT flatten() const // throw(std::bad_alloc)
+    {
+        if(!root_)
+            return StringT();
+        if(!root_->depth && root_->size == root_->str.size())
+            return root_->str;
+        storage_type stg(0, root_->size);
+        this->for_each_chunk(copier(const_cast<char_type*>(stg.begin())));
+        stg.seal();
+        return StringT(stg);
+    }
+
+private:
+    explicit const_rope(node_ptr const& root) // throw()
+        : root_(root)
+    {}
+
+    struct copier
+    {
+        char_type* to;
+
+        explicit copier(char_type* p) : to(p) {} // throw()
+
+        void operator()(char_type const* data, size_t size) // throw()
+        {
+            traits_type::copy(to, data, size);
+            to += size;
+        }
+    };
+
+    template<class F>
+    static void visit(node const* p, F& f)
+    {
+        for(; p->depth; p = p->right.get())
+            visit(p->left.get(), f);
+        f(p->data(), p->size);
+    }
+
+    static node_ptr make(node_ptr const& l, node_ptr const& r) // throw(std::bad_alloc)
+    {
+        if(!l->depth && !r->depth && l->size + r->size <= leaf_merge)
+        {
+            storage_type stg(0, l->size + r->size);
+            char_type* const p(const_cast<char_type*>(stg.begin()));
+            traits_type::copy(p, l->data(), l->size);
+            traits_type::copy(p + l->size, r->data(), r->size);
+            stg.seal();
+            return node_ptr(new node(StringT(stg), 0, l->size + r->size));
+        }
+        return node_ptr(new node(l, r));
+    }
+
+    // the depths of l and r differ by 2 at most, a rotation evens them out
+    static node_ptr balance(node_ptr const& l, node_ptr const& r) // throw(std::bad_alloc)
+    {
+        if(l->depth > r->depth + 1)
+        {
+            if(l->left->depth >= l->right->depth)
+                return make(l->left, make(l->right, r));
+            return make(make(l->left, l->right->left), make(l->right->right, r));
+        }
+        if(r->depth > l->depth + 1)
+        {
+            if(r->right->depth >= r->left->depth)
+                return make(make(l, r->left), r->right);
+            return make(make(l, r->left->left), make(r->left->right, r->right));
+        }
+        return make(l, r);
+    }
+
+    // the concatenation, the deeper tree is descended to a subtree as deep as the other one
+    static node_ptr join(node_ptr const& a, node_ptr const& b) // throw(std::bad_alloc)
+    {
+        if(!a)
+            return b;
+        if(!b)
+            return a;
+        if(a->depth > b->depth + 1)
+            return balance(a->left, join(a->right, b));
+        if(b->depth > a->depth + 1)
+            return balance(join(a, b->left), b->right);
+        return make(a, b);
+    }
+
+    // n > 0 characters from pos
+    static node_ptr slice(node_ptr const& p, size_t pos, size_t n) // throw(std::bad_alloc)
+    {
+        if(!pos && n == p->size)
+            return p;
+        if(!p->depth)
+            return node_ptr(new node(p->str, p->offset + pos, n));
+        size_t const left(p->left->size);
+        if(pos + n <= left)
+            return slice(p->left, pos, n);
+        if(pos >= left)
+            return slice(p->right, pos - left, n);
+        return join(slice(p->left, pos, left - pos), slice(p->right, 0, pos + n - left));
+    }
+
+private:
+    node_ptr root_;
+};
+
+template<class StringT>
+size_t const const_rope<StringT>::npos;
+
+template<class StringT>
+inline const_rope<StringT> operator+(const_rope<StringT> a, const_rope<StringT> const& b) // throw(std::bad_alloc)
+{
+    return a += b;
+}
+
+// more specialized than the operators of concatenation.hpp
+template<class CharT, class TraitsT, class StorageT>
+inline const_rope<const_string<CharT, TraitsT, StorageT> >
+operator+(const_rope<const_string<CharT, TraitsT, StorageT> > a, const_string<CharT, TraitsT, StorageT> const& b) // throw(std::bad_alloc)
+{
+    return a += const_rope<const_string<CharT, TraitsT, StorageT> >(b);
+}
+
+template<class CharT, class TraitsT, class StorageT>
+inline const_rope<const_string<CharT, TraitsT, StorageT> >
+operator+(const_string<CharT, TraitsT, StorageT> const& a, const_rope<const_string<CharT, TraitsT, StorageT> > const& b) // throw(std::bad_alloc)
+{
+    return const_rope<const_string<CharT, TraitsT, StorageT> >(a) += b;
+}
+
+namespace cs {
+namespace aux {
+
+template<class CharT, class TraitsT>
+struct ostream_chunk_writer
+{
+    std::basic_ostream<CharT, TraitsT>* os;
+
+    void operator()(CharT const* data, size_t size) const
+    {
+        os->write(data, size);
+    }
+};
+
+} // namespace aux {
+} // namespace cs {
+
+template<class CharT, class TraitsT, class StringT>
+inline std::basic_ostream<CharT, TraitsT>& operator<<(std::basic_ostream<CharT, TraitsT>& os, const_rope<StringT> const& r)
+{
+    cs::aux::ostream_chunk_writer<CharT, TraitsT> const w = { &os };
+    r.for_each_chunk(w);
+    return os;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_ROPE_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,204 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// search.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_SEARCH_HPP
+#define BOOST_CONST_STRING_SEARCH_HPP
+
+#include <string>
+#include <utility>
+#include <cstddef>
+
+#include "boost/type_traits/is_same.hpp"
+
+#include "boost/const_string/const_string.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+// an output iterator that counts the values written
+class counting_iterator
+{
+public:
+    explicit counting_iterator(size_t& n) : n_(&n) {} // throw()
+
+    counting_iterator& operator*() { return *this; } // throw()
+    counting_iterator& operator++() { return *this; } // throw()
+    counting_iterator& operator=(size_t) { ++*n_; return *this; } // throw()
+
+private:
+    size_t* n_;
+};
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A needle prepared once for searching many haystacks, e.g. a keyword in every line of a log.
+//
+// The way to search is picked by the length of the needle:
+//     a needle of up to 7 characters: its first character is found with traits_type::find(),
+//         which is memchr() for char, and the rest is compared at every hit;
+//     a longer one: Boyer-Moore-Horspool, the shift for the character under the last one
+//         of the needle is looked up in a table of 256 made once. Characters wider than
+//         a byte share the entries by their low byte, the shorter shift is kept.
+//         The table is keyed by the value of the character, so that Horspool is used
+//         with std::char_traits<> only. With other traits, e.g. case insensitive ones,
+//         longer needles are searched for the way short ones are, which honours eq().
+//
+// Horspool degrades to comparing at every position on periodic needles in periodic text,
+// such as "aaab" in "aaaa...", it is linear on text that doesn't repeat the needle's pattern.
+//
+// It is also a searcher for std::search() of C++17:
+//
+//     const_string_searcher<> const s(lit("ERROR"));
+//     for(size_t i(0); i != lines.size(); ++i)
+//         if(s.find(lines[i]) != s.npos)
+//             ...
+
+template<class StringT = const_string<char> >
+class const_string_searcher
+{
+public:
+    typedef StringT value_type;
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::traits_type traits_type;
+
+    static size_t const npos = static_cast<size_t>(-1);
+
+private:
+    enum { horspool_min_size = 8, table_size = 256 };
+
+    // whether the characters are equal only when their values are
+    static bool const bitwise_eq = boost::is_same<traits_type, std::char_traits<char_type> >::value;
+
+public:
+    explicit const_string_searcher(StringT const& needle) // throw()
+        : needle_(needle)
+    {
+        size_t const n(needle_.size());
+        if(!bitwise_eq || n < horspool_min_size)
+            return;
+        for(size_t i(0); i != table_size; ++i)
+            shift_[i] = n;
+        char_type const* const p(needle_.data());
+        for(size_t i(0); i != n - 1; ++i)
+            shift_[this->key(p[i])] = n - 1 - i;
+    }
+
+public:
+    StringT const& needle() const { return needle_; } // throw()
+
+    // the first occurrence of the needle in [first, last), last if there is none
+    char_type const* find(char_type const* first, char_type const* last) const // throw()
+    {
+        size_t const n(needle_.size());
+        char_type const* const p(needle_.data());
+        if(!bitwise_eq || n < horspool_min_size)
+        {
+            if(!n)
+                return first;
+            while(static_cast<size_t>(last - first) >= n)
+            {
+                char_type const* const hit(traits_type::find(first, last - first - (n - 1), p[0]));
+                if(!hit)
+                    return last;
+                if(!traits_type::compare(hit + 1, p + 1, n - 1))
+                    return hit;
+                first = hit + 1;
+            }
+            return last;
+        }
+
+        char_type const back(p[n - 1]);
+        while(static_cast<size_t>(last - first) >= n)
+        {
+            char_type const c(first[n - 1]);
+            if(traits_type::eq(c, back) && !traits_type::compare(first, p, n - 1))
+                return first;
+            first += shift_[this->key(c)];
+        }
+        return last;
+    }
+
+    // the position of the first occurrence at or after pos, npos if there is none
+    size_t find(StringT const& haystack, size_t pos = 0) const // throw()
+    {
+        size_t const size(haystack.size());
+        if(pos > size)
+            return npos;
+        char_type const* const first(haystack.data());
+        char_type const* const hit(this->find(first + pos, first + size));
+        return hit != first + size || (needle_.empty() && pos == size) ? hit - first : npos;
+    }
+
+    // writes the positions of the occurrences that don't overlap, left to right
+    template<class OutputIterator>
+    OutputIterator find_all(StringT const& haystack, OutputIterator out) const // throw(...) what *out = throws
+    {
+        size_t const n(needle_.size());
+        if(!n)
+        {
+            for(size_t i(0); i <= haystack.size(); ++i, ++out)
+                *out = i;
+            return out;
+        }
+        char_type const* const first(haystack.data());
+        char_type const* const last(first + haystack.size());
+        for(char_type const* p(first); (p = this->find(p, last)) != last; p += n, ++out)
+            *out = static_cast<size_t>(p - first);
+        return out;
+    }
+
+    // the number of the occurrences that don't overlap
+    size_t count(StringT const& haystack) const // throw()
+    {
+        size_t n(0);
+        this->find_all(haystack, cs::aux::counting_iterator(n));
+        return n;
+    }
+
+    // the searcher protocol of std::search() of C++17
+    std::pair<char_type const*, char_type const*> operator()(char_type const* first, char_type const* last) const // throw()
+    {
+        char_type const* const hit(this->find(first, last));
+        return std::make_pair(hit, hit == last ? last : hit + needle_.size());
+    }
+
+private:
+    static unsigned char key(char_type c) // throw()
+    {
+        return static_cast<unsigned char>(c);
+    }
+
+private:
+    StringT needle_;
+    size_t shift_[table_size]; // by the low byte of the character, for Horspool only
+};
+
+template<class StringT>
+size_t const const_string_searcher<StringT>::npos;
+
+template<class StringT>
+bool const const_string_searcher<StringT>::bitwise_eq;
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_SEARCH_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,281 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// sort.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_SORT_HPP
+#define BOOST_CONST_STRING_SORT_HPP
+
+#include <string>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+
+#include "boost/config.hpp"
+#include "boost/cstdint.hpp"
+#include "boost/type_traits/integral_constant.hpp"
+#include "boost/type_traits/is_same.hpp"
+#include "boost/type_traits/is_signed.hpp"
+#include "boost/type_traits/is_integral.hpp"
+#include "boost/type_traits/make_unsigned.hpp"
+
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+#   include <thread>
+#endif
+
+#include "boost/const_string/const_string.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Multikey quicksort (Bentley, Sedgewick) with cached keys.
+//
+// A key packs the next few characters of a string starting at the current depth
+// and, in the low byte, how many of them the string has. Keys are computed once per string
+// per depth into an array that is permuted along with the strings, so that partitioning
+// reads the characters of a string once per depth rather than once per comparison.
+// Equal keys with fewer characters than a key holds mean equal strings.
+//
+// The strings are exchanged with swap(), which for const_string with a stateless allocator
+// copies bytes and leaves the reference counters alone.
+
+typedef boost::uint64_t sort_key;
+
+// maps a character to an unsigned number of the same order as std::char_traits<>::lt()
+template<class CharT>
+inline sort_key radix_char(CharT c) // throw()
+{
+    typedef typename boost::make_unsigned<CharT>::type unsigned_type;
+    unsigned_type const u(static_cast<unsigned_type>(c));
+    return boost::is_signed<CharT>::value
+        ? u ^ (unsigned_type(1) << (sizeof(CharT) * 8 - 1))
+        : u
+        ;
+}
+
+// std::char_traits<char>::lt() compares unsigned char whatever the signedness of char is
+inline sort_key radix_char(char c) // throw()
+{
+    return static_cast<unsigned char>(c);
+}
+
+template<class StringT>
+struct multikey_sort
+{
+    typedef typename StringT::value_type char_type;
+    typedef typename StringT::traits_type traits_type;
+
+    enum { key_chars = 7 / sizeof(char_type) };
+    enum { insertion_sort_size = 16 };
+    enum { parallel_size = 1 << 14 };
+
+    template<class IteratorT>
+    static sort_key make_key(IteratorT i, size_t depth) // throw()
+    {
+        char_type const* const p(i->data() + depth);
+        size_t const n(std::min<size_t>(key_chars, i->size() - depth));
+        sort_key key(0);
+        for(size_t j(0); j != key_chars; ++j)
+            key = key << (sizeof(char_type) * 8) | (j < n ? radix_char(p[j]) : 0);
+        return key << 8 | n;
+    }
+
+    template<class IteratorT>
+    static void make_keys(IteratorT first, sort_key* keys, size_t n, size_t depth) // throw()
+    {
+        for(size_t i(0); i != n; ++i, ++first)
+            keys[i] = make_key(first, depth);
+    }
+
+    template<class IteratorT>
+    static void exchange(IteratorT first, sort_key* keys, size_t a, size_t b) // throw()
+    {
+        using std::swap;
+        swap(first[a], first[b]);
+        std::swap(keys[a], keys[b]);
+    }
+
+    static bool is_final(sort_key key) // throw()
+    {
+        return (key & 0xff) < key_chars;
+    }
+
+    template<class IteratorT>
+    static bool less(IteratorT a, sort_key a_key, IteratorT b, sort_key b_key, size_t depth) // throw()
+    {
+        if(a_key != b_key)
+            return a_key < b_key;
+        if(is_final(a_key))
+            return false;
+        depth += key_chars;
+        return cs::aux::compare_chars<traits_type>(
+              a->data() + depth, a->size() - depth
+            , b->data() + depth, b->size() - depth
+            ) < 0;
+    }
+
+    template<class IteratorT>
+    static void insertion_sort(IteratorT first, sort_key* keys, size_t n, size_t depth) // throw()
+    {
+        for(size_t i(1); i < n; ++i)
+            for(size_t j(i); j && less(first + j, keys[j], first + (j - 1), keys[j - 1], depth); --j)
+                exchange(first, keys, j, j - 1);
+    }
+
+    static sort_key median(sort_key a, sort_key b, sort_key c) // throw()
+    {
+        return a < b
+            ? (b < c ? b : a < c ? c : a)
+            : (a < c ? a : b < c ? c : b)
+            ;
+    }
+
+    // keys of [first, first + n) are those at depth
+    template<class IteratorT>
+    static void sort(IteratorT first, sort_key* keys, size_t n, size_t depth, unsigned threads) // throw()
+    {
+        while(n >= insertion_sort_size)
+        {
+            sort_key const pivot(median(keys[0], keys[n / 2], keys[n - 1]));
+            size_t lt(0), i(0), gt(n);
+            while(i != gt)
+            {
+                if(keys[i] < pivot)
+                    exchange(first, keys, lt++, i++);
+                else if(pivot < keys[i])
+                    exchange(first, keys, i, --gt);
+                else
+                    ++i;
+            }
+
+            if(!sort_parts(first, keys, lt, gt, n, depth, threads))
+            {
+                sort(first, keys, lt, depth, 1);
+                sort(first + gt, keys + gt, n - gt, depth, 1);
+            }
+
+            if(is_final(pivot))
+                return;
+            first += lt;
+            keys += lt;
+            n = gt - lt;
+            depth += key_chars;
+            make_keys(first, keys, n, depth);
+        }
+        insertion_sort(first, keys, n, depth);
+    }
+
+    // sorts the parts less and greater than the pivot on another thread and this one
+    template<class IteratorT>
+    static bool sort_parts(IteratorT first, sort_key* keys, size_t lt, size_t gt, size_t n, size_t depth, unsigned threads) // throw()
+    {
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+        if(threads > 1 && n >= parallel_size)
+        {
+            unsigned const half(threads / 2);
+            try
+            {
+                std::thread t(&multikey_sort::sort<IteratorT>, first, keys, lt, depth, half);
+                sort(first + gt, keys + gt, n - gt, depth, threads - half);
+                t.join();
+                return true;
+            }
+            catch(...) // failed to start a thread
+            {}
+        }
+#else
+        (void)first; (void)keys; (void)lt; (void)gt; (void)n; (void)depth; (void)threads;
+#endif
+        return false;
+    }
+};
+
+template<class IteratorT, class StringT>
+inline void sort_strings(IteratorT first, IteratorT last, unsigned threads, StringT const*, boost::true_type)
+{
+    size_t const n(std::distance(first, last));
+    std::vector<sort_key> keys(n);
+    if(!n)
+        return;
+    multikey_sort<StringT>::make_keys(first, &keys[0], n, 0);
+    multikey_sort<StringT>::sort(first, &keys[0], n, 0, threads);
+}
+
+// other orders of characters are left to std::sort()
+template<class IteratorT, class StringT>
+inline void sort_strings(IteratorT first, IteratorT last, unsigned, StringT const*, boost::false_type)
+{
+    std::sort(first, last);
+}
+
+template<class StringT>
+struct is_radix_sortable
+    : boost::integral_constant<
+          bool
+        , boost::is_integral<typename StringT::value_type>::value
+          && sizeof(typename StringT::value_type) <= 4
+          && boost::is_same<
+                  typename StringT::traits_type
+                , std::char_traits<typename StringT::value_type>
+                >::value
+        >
+{};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Sorts a random access range of const_string or std::basic_string in ascending order.
+//
+// It is not stable. The threads argument is the number of threads to sort a large range with,
+// without <thread> the range is sorted on the calling thread.
+
+template<class IteratorT>
+inline void sort_strings(IteratorT first, IteratorT last) // throw(std::bad_alloc)
+{
+    typedef typename std::iterator_traits<IteratorT>::value_type string;
+    cs::aux::sort_strings(first, last, 1, static_cast<string const*>(0), cs::aux::is_radix_sortable<string>());
+}
+
+template<class IteratorT>
+inline void sort_strings(IteratorT first, IteratorT last, unsigned threads) // throw(std::bad_alloc)
+{
+    typedef typename std::iterator_traits<IteratorT>::value_type string;
+    cs::aux::sort_strings(first, last, threads, static_cast<string const*>(0), cs::aux::is_radix_sortable<string>());
+}
+
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+
+// sorts on all the cores
+template<class IteratorT>
+inline void parallel_sort_strings(IteratorT first, IteratorT last) // throw(std::bad_alloc)
+{
+    unsigned const cores(std::thread::hardware_concurrency());
+    boost::sort_strings(first, last, cores ? cores : 1);
+}
+
+#endif // BOOST_NO_CXX11_HDR_THREAD
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_SORT_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
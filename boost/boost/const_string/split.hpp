@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// split.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_SPLIT_HPP
+#define BOOST_CONST_STRING_SPLIT_HPP
+
+#include <string>
+#include <iterator>
+#include <cstddef>
+
+#include "boost/type_traits/integral_constant.hpp"
+#include "boost/type_traits/is_same.hpp"
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/detail/simd.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cs {
+namespace aux {
+
+template<class TraitsT>
+struct is_byte_traits : boost::is_same<TraitsT, std::char_traits<char> > {};
+
+// finds a delimiter with traits_type::find(), which is memchr() for char
+template<class StringT>
+class char_finder
+{
+public:
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::traits_type traits_type;
+
+    enum { skip_empty = false };
+
+public:
+    explicit char_finder(char_type c) // throw()
+        : c_(c)
+    {}
+
+    char_type const* find(char_type const* first, char_type const* last) const // throw()
+    {
+        char_type const* const p(traits_type::find(first, last - first, c_));
+        return p ? p : last;
+    }
+
+    bool contains(char_type c) const // throw()
+    {
+        return traits_type::eq(c, c_);
+    }
+
+private:
+    char_type c_;
+};
+
+// finds any of a set of delimiters, bytes are matched 64 a step
+template<class StringT, bool bytes = is_byte_traits<typename StringT::traits_type>::value>
+class set_finder
+{
+public:
+    typedef typename StringT::char_type char_type;
+
+    enum { skip_empty = true };
+
+public:
+    set_finder(char_type const* s, size_t n) // throw()
+        : set_(s, n)
+    {}
+
+    char_type const* find(char_type const* first, char_type const* last) const // throw()
+    {
+        return reinterpret_cast<char_type const*>(cs::aux::find_byte(
+              reinterpret_cast<unsigned char const*>(first)
+            , reinterpret_cast<unsigned char const*>(last)
+            , set_
+            ));
+    }
+
+    bool contains(char_type c) const // throw()
+    {
+        return set_.contains(static_cast<unsigned char>(c));
+    }
+
+private:
+    byte_set set_;
+};
+
+template<class StringT>
+class set_finder<StringT, false>
+{
+public:
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::traits_type traits_type;
+
+    enum { skip_empty = true };
+
+public:
+    set_finder(char_type const* s, size_t n) // throw(std::bad_alloc)
+        : set_(s, n)
+    {}
+
+    char_type const* find(char_type const* first, char_type const* last) const // throw()
+    {
+        for(; first != last && !this->contains(*first); ++first)
+            ;
+        return first;
+    }
+
+    bool contains(char_type c) const // throw()
+    {
+        return 0 != traits_type::find(set_.data(), set_.size(), c);
+    }
+
+private:
+    StringT set_;
+};
+
+} // namespace aux {
+} // namespace cs {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A lazy range of the fields of a string separated by delimiters.
+//
+// A field of a string short enough to be stored inside a const_string is a copy,
+// which takes no allocation, a field of a longer one refers to its characters like
+// ref_substr() does. So the fields of a long string are valid as long as the string is,
+// the range keeps a copy of it; copy a field with its begin() and end() to keep it longer.
+// The iterators are valid as long as the range is.
+
+template<class StringT, class FinderT>
+class field_range
+{
+public:
+    typedef StringT value_type;
+    typedef typename StringT::char_type char_type;
+
+    class iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef StringT value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef StringT const* pointer;
+        typedef StringT const& reference;
+
+    public:
+        iterator() // throw()
+            : range_(0)
+            , first_(0)
+            , next_(0)
+        {}
+
+        StringT const& operator*() const { return field_; } // throw()
+        StringT const* operator->() const { return &field_; } // throw()
+
+        iterator& operator++() // throw()
+        {
+            if(next_)
+                this->find(next_);
+            else
+                *this = iterator();
+            return *this;
+        }
+
+        iterator operator++(int) // throw()
+        {
+            iterator const i(*this);
+            ++*this;
+            return i;
+        }
+
+        friend bool operator==(iterator const& a, iterator const& b) // throw()
+        {
+            return a.range_ == b.range_ && a.first_ == b.first_;
+        }
+
+        friend bool operator!=(iterator const& a, iterator const& b) // throw()
+        {
+            return !(a == b);
+        }
+
+    private:
+        friend class field_range;
+
+        explicit iterator(field_range const* r) // throw()
+            : range_(r)
+            , first_(0)
+            , next_(0)
+        {
+            this->find(r->str_.data());
+        }
+
+        // the field starting at p or the first one after it when empty fields are skipped
+        void find(char_type const* p) // throw()
+        {
+            char_type const* const end(range_->str_.data() + range_->str_.size());
+            if(FinderT::skip_empty)
+            {
+                for(; p != end && range_->finder_.contains(*p); ++p)
+                    ;
+                if(p == end)
+                {
+                    *this = iterator();
+                    return;
+                }
+            }
+            char_type const* const d(range_->finder_.find(p, end));
+            first_ = p;
+            next_ = d != end ? d + 1 : 0;
+            field_ = range_->field(p, d);
+        }
+
+    private:
+        field_range const* range_; // 0 past the last field
+        char_type const* first_; // of the field in the string
+        char_type const* next_; // 0 after the last field
+        StringT field_;
+    };
+
+    typedef iterator const_iterator;
+
+public:
+    field_range(StringT const& s, FinderT const& f) // throw()
+        : str_(s)
+        , finder_(f)
+    {}
+
+    iterator begin() const { return iterator(this); } // throw()
+    iterator end() const { return iterator(); } // throw()
+
+private:
+    StringT field(char_type const* first, char_type const* last) const // throw()
+    {
+        return str_.size() < StringT::storage_type::effective_buffer_size_chars
+            ? StringT(first, last)
+            : str_.ref_substr(first - str_.data(), last - first)
+            ;
+    }
+
+private:
+    StringT str_;
+    FinderT finder_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// split(s, ',') yields the n + 1 fields of a string with n delimiters, empty ones included:
+//
+//     for(auto const& field : split(line, '\t'))
+//
+// tokenize(s, " \t") yields the runs of characters not in the set, never an empty one.
+
+template<class CharT, class TraitsT, class StorageT>
+inline field_range<const_string<CharT, TraitsT, StorageT>, cs::aux::char_finder<const_string<CharT, TraitsT, StorageT> > >
+split(const_string<CharT, TraitsT, StorageT> const& s, CharT delimiter) // throw()
+{
+    typedef const_string<CharT, TraitsT, StorageT> string;
+    return field_range<string, cs::aux::char_finder<string> >(s, cs::aux::char_finder<string>(delimiter));
+}
+
+template<class CharT, class TraitsT, class StorageT>
+inline field_range<const_string<CharT, TraitsT, StorageT>, cs::aux::set_finder<const_string<CharT, TraitsT, StorageT> > >
+tokenize(const_string<CharT, TraitsT, StorageT> const& s, CharT const* delimiters) // throw(std::bad_alloc)
+{
+    typedef const_string<CharT, TraitsT, StorageT> string;
+    return field_range<string, cs::aux::set_finder<string> >(s, cs::aux::set_finder<string>(delimiters, TraitsT::length(delimiters)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_SPLIT_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
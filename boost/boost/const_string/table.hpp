@@ -0,0 +1,235 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// table.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_TABLE_HPP
+#define BOOST_CONST_STRING_TABLE_HPP
+
+#include <new>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/detail/key.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// An append only table of strings stored back to back in large blocks of characters.
+//
+// The strings it hands out refer to the characters in place and share the reference counter
+// of the table's storage, so that a string costs no allocation and no header of its own,
+// only its characters with the trailing zero and a slice (owner, pointer, size) in the table.
+// The storage lives until the table and the last of the strings are gone.
+//
+// It is meant for many small immutable strings loaded at once, e.g. at startup:
+//
+//     const_string_table<> names;
+//     const_string<char> const name(names.push_back(line));
+//
+// The table is not thread safe, the strings are as safe as any const_string.
+
+template<
+      class StringT = const_string<char>
+    , class AllocatorT = std::allocator<typename StringT::char_type>
+    >
+class const_string_table
+{
+public:
+    typedef StringT value_type;
+    typedef AllocatorT allocator_type;
+    typedef size_t size_type;
+    typedef cs::aux::string_key<StringT> key;
+
+private:
+    typedef typename StringT::char_type char_type;
+    typedef typename StringT::traits_type traits_type;
+    typedef typename StringT::storage_type storage_type;
+    typedef cs::aux::external_slice<char_type> slice;
+    typedef std::pair<char_type*, size_t> blob;
+
+    typedef typename AllocatorT::template rebind<char_type>::other char_allocator;
+    typedef typename AllocatorT::template rebind<slice>::other slice_allocator;
+    typedef typename AllocatorT::template rebind<blob>::other blob_allocator;
+    typedef typename AllocatorT::template rebind<slice*>::other chunk_allocator;
+
+    enum { chunk_size = 1024 };
+
+    struct owner
+        : cs::aux::external_owner
+        , char_allocator
+    {
+        typedef typename AllocatorT::template rebind<owner>::other owner_allocator;
+
+        // the slices are allocated in chunks of chunk_size, so that they never move
+        std::vector<slice*, chunk_allocator> chunks;
+        size_t size;
+        std::vector<blob, blob_allocator> blobs;
+        char_type* tail;
+        size_t tail_size;
+
+        explicit owner(AllocatorT const& a)
+            : cs::aux::external_owner(&owner::destroy)
+            , char_allocator(a)
+            , chunks(chunk_allocator(a))
+            , size(0)
+            , blobs(blob_allocator(a))
+            , tail(0)
+            , tail_size(0)
+        {}
+
+        ~owner()
+        {
+            slice_allocator sa(static_cast<char_allocator const&>(*this));
+            for(typename std::vector<slice*, chunk_allocator>::iterator i(chunks.begin()), e(chunks.end()); i != e; ++i)
+                sa.deallocate(*i, chunk_size);
+            for(typename std::vector<blob, blob_allocator>::iterator i(blobs.begin()), e(blobs.end()); i != e; ++i)
+                this->char_allocator::deallocate(i->first, i->second);
+        }
+
+        slice& operator[](size_t index) // throw()
+        {
+            return chunks[index / chunk_size][index % chunk_size];
+        }
+
+        // the next slice, a chunk is allocated when the last one is full
+        slice& push_back() // throw(std::bad_alloc)
+        {
+            if(size == chunks.size() * chunk_size)
+            {
+                if(chunks.size() == chunks.capacity())
+                    chunks.reserve(2 * chunks.size() + 1);
+                slice_allocator sa(static_cast<char_allocator const&>(*this));
+                chunks.push_back(sa.allocate(chunk_size));
+            }
+            return (*this)[size++];
+        }
+
+        static owner* create(AllocatorT const& a) // throw(std::bad_alloc)
+        {
+            owner_allocator oa(a);
+            owner* const p(oa.allocate(1));
+            try
+            {
+                return new (p) owner(a);
+            }
+            catch(...)
+            {
+                oa.deallocate(p, 1);
+                throw;
+            }
+        }
+
+        static void destroy(cs::aux::external_owner* o) // throw()
+        {
+            owner* const p(static_cast<owner*>(o));
+            owner_allocator oa(static_cast<char_allocator const&>(*p));
+            p->~owner();
+            oa.deallocate(p, 1);
+        }
+
+        // copies the characters with the trailing zero to the current block or a new one
+        char_type const* append(char_type const* s, size_t n, size_t blob_chars) // throw(std::bad_alloc)
+        {
+            if(tail_size < n + 1)
+            {
+                if(blobs.size() == blobs.capacity())
+                    blobs.reserve(2 * blobs.size() + 1);
+                size_t const size(std::max(blob_chars, n + 1));
+                tail = this->char_allocator::allocate(size);
+                tail_size = size;
+                blobs.push_back(blob(tail, size));
+            }
+            char_type* const p(tail);
+            traits_type::copy(p, s, n);
+            p[n] = char_type();
+            tail += n + 1;
+            tail_size -= n + 1;
+            return p;
+        }
+    };
+
+public:
+    explicit const_string_table(size_t blob_chars = 0x10000 / sizeof(char_type), AllocatorT const& a = AllocatorT()) // throw(std::bad_alloc)
+        : owner_(owner::create(a))
+        , blob_chars_(blob_chars)
+    {}
+
+    ~const_string_table()
+    {
+        cs::aux::release(owner_);
+    }
+
+public:
+    size_t size() const { return owner_->size; } // throw()
+    bool empty() const { return !owner_->size; } // throw()
+
+    // the characters allocated for the strings, the wasted tails of blocks included
+    size_t capacity_chars() const // throw()
+    {
+        size_t n(0);
+        for(size_t i(0), e(owner_->blobs.size()); i != e; ++i)
+            n += owner_->blobs[i].second;
+        return n;
+    }
+
+    value_type operator[](size_t index) const // throw()
+    {
+        return value_type(storage_type((*owner_)[index]));
+    }
+
+    value_type at(size_t index) const // throw(std::out_of_range)
+    {
+        if(index < this->size())
+            return (*this)[index];
+        else
+            throw std::out_of_range("invalid index");
+    }
+
+    value_type back() const // throw()
+    {
+        return (*this)[owner_->size - 1];
+    }
+
+    // appends a copy of any string type string_key<> accepts and returns the string in the table
+    value_type push_back(key const& k) // throw(std::bad_alloc, std::length_error)
+    {
+        if(k.size > value_type().max_size())
+            throw std::length_error("const_string_table: the source string is way too long");
+
+        char_type const* const data(owner_->append(k.data, k.size, blob_chars_));
+        slice& s(owner_->push_back()); // if it throws the characters are wasted, no harm done
+        s.owner = owner_;
+        s.data = data;
+        s.size = k.size;
+        return this->back();
+    }
+
+private:
+    const_string_table(const_string_table const&);
+    const_string_table& operator=(const_string_table const&);
+
+private:
+    owner* owner_;
+    size_t blob_chars_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_TABLE_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
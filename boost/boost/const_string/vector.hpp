@@ -0,0 +1,335 @@
+////////////////////////////////////////////////////////////////////////////////////////////////
+// vector.hpp
+
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONST_STRING_VECTOR_HPP
+#define BOOST_CONST_STRING_VECTOR_HPP
+
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#include "boost/static_assert.hpp"
+#include "boost/aligned_storage.hpp"
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/relocatable.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace boost {
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// A subset of std::vector<> interface for trivially relocatable elements.
+//
+// Growing, inserting and erasing move the elements with memcpy() / memmove()
+// instead of copying and destroying them, which for const_string means
+// no reference counter is touched and the inline buffers are not copied character by character.
+
+template<
+      class StringT = const_string<char>
+    , class AllocatorT = std::allocator<StringT>
+    >
+class const_string_vector
+    : private AllocatorT::template rebind<StringT>::other
+{
+private:
+    BOOST_STATIC_ASSERT(cs::is_trivially_relocatable<StringT>::value);
+    typedef typename AllocatorT::template rebind<StringT>::other allocator;
+
+public:
+    typedef StringT value_type;
+    typedef AllocatorT allocator_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef value_type& reference;
+    typedef value_type const& const_reference;
+    typedef value_type* pointer;
+    typedef value_type const* const_pointer;
+    typedef value_type* iterator;
+    typedef value_type const* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+public:
+    const_string_vector() // throw()
+        : begin_(0)
+        , end_(0)
+        , capacity_(0)
+    {}
+
+    explicit const_string_vector(AllocatorT const& a) // throw()
+        : allocator(a)
+        , begin_(0)
+        , end_(0)
+        , capacity_(0)
+    {}
+
+    explicit const_string_vector(size_t n, value_type const& value = value_type()) // throw(std::bad_alloc)
+        : begin_(0)
+        , end_(0)
+        , capacity_(0)
+    {
+        this->resize(n, value);
+    }
+
+    const_string_vector(const_string_vector const& other) // throw(std::bad_alloc)
+        : allocator(other)
+        , begin_(0)
+        , end_(0)
+        , capacity_(0)
+    {
+        this->insert(end_, other.begin(), other.end());
+    }
+
+    const_string_vector& operator=(const_string_vector const& other) // throw(std::bad_alloc)
+    {
+        const_string_vector(other).swap(*this);
+        return *this;
+    }
+
+    ~const_string_vector()
+    {
+        this->clear();
+        this->deallocate(begin_, capacity_);
+    }
+
+public:
+    iterator begin() { return begin_; } // throw()
+    iterator end() { return end_; } // throw()
+    const_iterator begin() const { return begin_; } // throw()
+    const_iterator end() const { return end_; } // throw()
+    reverse_iterator rbegin() { return reverse_iterator(end_); } // throw()
+    reverse_iterator rend() { return reverse_iterator(begin_); } // throw()
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end_); } // throw()
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin_); } // throw()
+
+    size_t size() const { return end_ - begin_; } // throw()
+    size_t capacity() const { return capacity_; } // throw()
+    bool empty() const { return begin_ == end_; } // throw()
+    size_t max_size() const { return static_cast<size_t>(-1) / sizeof(value_type); } // throw()
+    allocator_type get_allocator() const { return allocator_type(static_cast<allocator const&>(*this)); } // throw()
+
+    value_type* data() { return begin_; } // throw()
+    value_type const* data() const { return begin_; } // throw()
+
+    reference operator[](size_t index) { return begin_[index]; } // throw()
+    const_reference operator[](size_t index) const { return begin_[index]; } // throw()
+    reference front() { return *begin_; } // throw()
+    const_reference front() const { return *begin_; } // throw()
+    reference back() { return end_[-1]; } // throw()
+    const_reference back() const { return end_[-1]; } // throw()
+
+    reference at(size_t index) // throw(std::out_of_range)
+    {
+        if(index < this->size())
+            return begin_[index];
+        else
+            throw std::out_of_range("invalid index");
+    }
+
+    const_reference at(size_t index) const // throw(std::out_of_range)
+    {
+        if(index < this->size())
+            return begin_[index];
+        else
+            throw std::out_of_range("invalid index");
+    }
+
+public:
+    void reserve(size_t n) // throw(std::bad_alloc, std::length_error)
+    {
+        if(n > capacity_)
+            this->reallocate(n);
+    }
+
+    void push_back(value_type const& value) // throw(std::bad_alloc)
+    {
+        if(end_ != begin_ + capacity_)
+        {
+            new (end_) value_type(value);
+            ++end_;
+        }
+        else
+            this->insert(end_, value);
+    }
+
+    void pop_back() // throw()
+    {
+        (--end_)->~value_type();
+    }
+
+    iterator insert(iterator pos, value_type const& value) // throw(std::bad_alloc)
+    {
+        return this->insert(pos, size_t(1), value);
+    }
+
+    iterator insert(iterator pos, size_t n, value_type const& value) // throw(std::bad_alloc)
+    {
+        size_t const index(pos - begin_);
+        if(!n)
+            return pos;
+
+        // value may be an element of this vector, so that it is copied before anything is relocated
+        typename boost::aligned_storage<sizeof(value_type), boost::alignment_of<value_type>::value>::type copy;
+        new (copy.address()) value_type(value);
+        value_type* const t(static_cast<value_type*>(copy.address()));
+
+        try
+        {
+            this->open_gap(index, n);
+        }
+        catch(...)
+        {
+            t->~value_type();
+            throw;
+        }
+
+        value_type* const gap(begin_ + index);
+        std::uninitialized_fill(gap, gap + n - 1, *t); // copying a const_string doesn't throw
+        cs::relocate(t, t + 1, gap + n - 1);
+        return gap;
+    }
+
+    template<class IteratorT>
+    iterator insert(iterator pos, IteratorT first, IteratorT last) // throw(std::bad_alloc), [first, last) must not refer into *this
+    {
+        size_t const index(pos - begin_);
+        size_t const n(std::distance(first, last));
+        if(!n)
+            return pos;
+
+        this->open_gap(index, n);
+        value_type* const gap(begin_ + index);
+        value_type* p(gap);
+        try
+        {
+            for(; first != last; ++first, ++p)
+                new (p) value_type(*first);
+        }
+        catch(...)
+        {
+            // destroy what has been constructed and close the gap
+            for(; p != gap; --p)
+                p[-1].~value_type();
+            cs::relocate(gap + n, end_, gap);
+            end_ -= n;
+            throw;
+        }
+        return gap;
+    }
+
+    iterator erase(iterator pos) // throw()
+    {
+        return this->erase(pos, pos + 1);
+    }
+
+    iterator erase(iterator first, iterator last) // throw()
+    {
+        for(iterator i(first); i != last; ++i)
+            i->~value_type();
+        cs::relocate(last, end_, first);
+        end_ -= last - first;
+        return first;
+    }
+
+    void resize(size_t n, value_type const& value = value_type()) // throw(std::bad_alloc)
+    {
+        size_t const size(this->size());
+        if(n < size)
+            this->erase(begin_ + n, end_);
+        else
+            this->insert(end_, n - size, value);
+    }
+
+    void clear() // throw()
+    {
+        this->erase(begin_, end_);
+    }
+
+    void swap(const_string_vector& other) // throw()
+    {
+        std::swap(static_cast<allocator&>(*this), static_cast<allocator&>(other));
+        std::swap(begin_, other.begin_);
+        std::swap(end_, other.end_);
+        std::swap(capacity_, other.capacity_);
+    }
+
+private:
+    // relocates [index, size) n elements towards the end, growing the storage if required
+    void open_gap(size_t index, size_t n) // throw(std::bad_alloc, std::length_error)
+    {
+        size_t const size(this->size());
+        if(n > this->max_size() - size)
+            throw std::length_error("const_string_vector");
+
+        if(size + n > capacity_)
+            this->reallocate(std::max(size + n, 2 * capacity_), index, n);
+        else
+            cs::relocate(begin_ + index, end_, begin_ + index + n);
+        end_ += n;
+    }
+
+    // moves the elements to a new block of n elements leaving a gap of gap_size elements at gap_index
+    void reallocate(size_t n, size_t gap_index = 0, size_t gap_size = 0) // throw(std::bad_alloc, std::length_error)
+    {
+        if(n > this->max_size())
+            throw std::length_error("const_string_vector");
+
+        size_t const size(this->size());
+        value_type* const p(this->allocator::allocate(n));
+        cs::relocate(begin_, begin_ + gap_index, p);
+        cs::relocate(begin_ + gap_index, end_, p + gap_index + gap_size);
+        this->deallocate(begin_, capacity_);
+        begin_ = p;
+        end_ = p + size;
+        capacity_ = n;
+    }
+
+    void deallocate(value_type* p, size_t n) // throw()
+    {
+        if(p)
+            this->allocator::deallocate(p, n);
+    }
+
+private:
+    value_type* begin_;
+    value_type* end_;
+    size_t capacity_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class StringT, class AllocatorT>
+inline void swap(const_string_vector<StringT, AllocatorT>& a, const_string_vector<StringT, AllocatorT>& b) // throw()
+{
+    a.swap(b);
+}
+
+template<class StringT, class AllocatorT>
+inline bool operator==(const_string_vector<StringT, AllocatorT> const& a, const_string_vector<StringT, AllocatorT> const& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template<class StringT, class AllocatorT>
+inline bool operator!=(const_string_vector<StringT, AllocatorT> const& a, const_string_vector<StringT, AllocatorT> const& b)
+{
+    return !(a == b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace boost
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // BOOST_CONST_STRING_VECTOR_HPP
+
+////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,142 @@
+// Copyright (c) 2004 Maxim Yegorushkin
+//
+// Use, modification and distribution are subject to the
+// Boost Software License, Version 1.0. (See accompanying file
+// LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Compares const_string_pool_allocator<> with std::allocator<> on strings of 16 to 256 characters.
+//
+// Every thread keeps a window of live strings and replaces a random one of them at every step,
+// so that blocks of all the sizes are allocated and freed out of order, as in the churn
+// benchmarks of jemalloc. Every so often a thread hands its window over to the next thread,
+// which frees the strings, so that blocks are freed on other threads than they came from.
+//
+// usage: pool_benchmark [threads [steps per thread]]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include "boost/config.hpp"
+
+#if defined(BOOST_NO_CXX11_HDR_THREAD) || defined(BOOST_NO_CXX11_HDR_CHRONO) || defined(BOOST_NO_CXX11_HDR_MUTEX)
+
+int main()
+{
+    std::printf("pool_benchmark needs C++11 <thread>, <chrono> and <mutex>\n");
+    return 0;
+}
+
+#else
+
+#include <thread>
+#include <chrono>
+#include <mutex>
+
+#include "boost/const_string/const_string.hpp"
+#include "boost/const_string/pool.hpp"
+
+namespace {
+
+enum { window_size = 1024, handover_steps = 4096, min_size = 16, max_size = 256 };
+
+typedef boost::const_string<char> std_string;
+typedef boost::const_string<
+      char
+    , std::char_traits<char>
+    , boost::const_string_storage<std::char_traits<char>, boost::const_string_pool_allocator<char> >
+    > pooled_string;
+
+// a cheap generator, the same sequence for both allocators
+struct xorshift
+{
+    unsigned long long state;
+
+    explicit xorshift(unsigned long long seed) : state(seed * 0x9e3779b97f4a7c15ull | 1) {}
+
+    unsigned operator()()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<unsigned>(state >> 32);
+    }
+};
+
+// the windows handed over from a thread to the next one
+template<class StringT>
+struct mailboxes
+{
+    std::vector<std::mutex> locks;
+    std::vector<std::vector<StringT> > boxes;
+
+    explicit mailboxes(unsigned n) : locks(n), boxes(n) {}
+};
+
+template<class StringT>
+void churn(unsigned id, unsigned threads, unsigned steps, mailboxes<StringT>* mail)
+{
+    static char const chars[max_size + 1] = { 0 };
+    xorshift random(id + 1);
+    std::vector<StringT> window(window_size);
+    std::vector<StringT> received;
+
+    for(unsigned step(0); step != steps; ++step)
+    {
+        size_t const size(min_size + random() % (max_size - min_size + 1));
+        window[random() % window_size] = StringT(chars, size);
+
+        if(step % handover_steps == handover_steps - 1)
+        {
+            // give the window to the next thread and free the one given to this thread
+            unsigned const next((id + 1) % threads);
+            {
+                std::lock_guard<std::mutex> lock(mail->locks[next]);
+                mail->boxes[next].swap(window);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mail->locks[id]);
+                received.swap(mail->boxes[id]);
+            }
+            received.clear();
+            window.resize(window_size);
+        }
+    }
+}
+
+template<class StringT>
+double run(unsigned threads, unsigned steps)
+{
+    mailboxes<StringT> mail(threads);
+    std::chrono::steady_clock::time_point const start(std::chrono::steady_clock::now());
+    std::vector<std::thread> workers;
+    for(unsigned i(0); i != threads; ++i)
+        workers.push_back(std::thread(&churn<StringT>, i, threads, steps, &mail));
+    for(unsigned i(0); i != threads; ++i)
+        workers[i].join();
+    mail.boxes.clear();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace {
+
+int main(int ac, char** av)
+{
+    unsigned const cores(std::thread::hardware_concurrency());
+    unsigned const max_threads(ac > 1 ? std::atoi(av[1]) : (cores ? cores : 1));
+    unsigned const steps(ac > 2 ? std::atoi(av[2]) : 2000000);
+
+    std::printf("%8s %16s %16s %8s\n", "threads", "std::allocator", "pool_allocator", "ratio");
+    for(unsigned threads(1);; threads = std::min(2 * threads, max_threads))
+    {
+        double const s(run<std_string>(threads, steps));
+        double const p(run<pooled_string>(threads, steps));
+        std::printf("%8u %15.3fs %15.3fs %8.2f\n", threads, s, p, s / p);
+        if(threads >= max_threads)
+            break;
+    }
+    return 0;
+}
+
+#endif
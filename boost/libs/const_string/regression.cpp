@@ -18,11 +18,172 @@
 
 #include <vector>
 #include <set>
+#include <map>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+
+#ifdef BOOST_HAS_UNISTD_H
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/socket.h>
+#endif
+
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+#   include <thread>
+#   include <atomic>
+#endif
 
 #include "boost/const_string/const_string.hpp"
 #include "boost/const_string/concatenation.hpp"
 #include "boost/const_string/format.hpp"
 #include "boost/const_string/io.hpp"
+#include "boost/const_string/hash.hpp"
+#include "boost/const_string/literal.hpp"
+#include "boost/const_string/vector.hpp"
+#include "boost/const_string/hash_map.hpp"
+#include "boost/const_string/functional.hpp"
+#include "boost/const_string/prefix_storage.hpp"
+#include "boost/const_string/compact_storage.hpp"
+#include "boost/const_string/sort.hpp"
+#include "boost/const_string/table.hpp"
+#include "boost/const_string/dedup.hpp"
+#include "boost/const_string/pool.hpp"
+#include "boost/const_string/atomic.hpp"
+#include "boost/const_string/intern.hpp"
+#include "boost/const_string/split.hpp"
+#include "boost/const_string/parallel.hpp"
+#include "boost/const_string/search.hpp"
+#include "boost/const_string/multi_pattern.hpp"
+#include "boost/const_string/rope.hpp"
+#include "boost/const_string/gather.hpp"
+#include "boost/const_string/file.hpp"
+#include "boost/functional/hash.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// allocation accounting: global operator new / delete hooks and an allocator for the storage
+
+struct allocation_count
+{
+    size_t new_calls;
+    size_t allocate_calls;
+    size_t deallocate_calls;
+
+    static allocation_count global;
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+    static std::atomic<size_t> global_new_calls; // operator new is called on other threads too
+#endif
+
+    static allocation_count now()
+    {
+        allocation_count r(global);
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+        r.new_calls = global_new_calls;
+#endif
+        return r;
+    }
+
+    static void count_new()
+    {
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+        ++global_new_calls;
+#else
+        ++global.new_calls;
+#endif
+    }
+
+    allocation_count operator-(allocation_count const& other) const
+    {
+        allocation_count r;
+        r.new_calls = new_calls - other.new_calls;
+        r.allocate_calls = allocate_calls - other.allocate_calls;
+        r.deallocate_calls = deallocate_calls - other.deallocate_calls;
+        return r;
+    }
+};
+
+allocation_count allocation_count::global = { 0, 0, 0 };
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+std::atomic<size_t> allocation_count::global_new_calls(0);
+#endif
+
+void* operator new(size_t n)
+{
+    allocation_count::count_new();
+    if(void* const p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t n)
+{
+    return ::operator new(n);
+}
+
+void operator delete(void* p) BOOST_NOEXCEPT_OR_NOTHROW
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) BOOST_NOEXCEPT_OR_NOTHROW
+{
+    ::operator delete(p);
+}
+
+#ifdef __cpp_sized_deallocation
+
+void operator delete(void* p, size_t) BOOST_NOEXCEPT_OR_NOTHROW
+{
+    ::operator delete(p);
+}
+
+void operator delete[](void* p, size_t) BOOST_NOEXCEPT_OR_NOTHROW
+{
+    ::operator delete(p);
+}
+
+#endif // __cpp_sized_deallocation
+
+size_t wrong_size_deallocations(0); // by counting_allocator<>
+
+template<class T>
+struct counting_allocator : std::allocator<T>
+{
+    template<class U>
+    struct rebind
+    {
+        typedef counting_allocator<U> other;
+    };
+
+    counting_allocator() {}
+
+    template<class U>
+    counting_allocator(counting_allocator<U> const&) {}
+
+    // the element count is kept in front of the block, to check the one it is freed with
+    enum { count_elements = (16 + sizeof(T) - 1) / sizeof(T) };
+
+    T* allocate(size_t n, void const* = 0)
+    {
+        ++allocation_count::global.allocate_calls;
+        T* const p(std::allocator<T>::allocate(n + count_elements));
+        *reinterpret_cast<size_t*>(p) = n;
+        return p + count_elements;
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        ++allocation_count::global.deallocate_calls;
+        p -= count_elements;
+        if(*reinterpret_cast<size_t*>(p) != n)
+            ++wrong_size_deallocations;
+        std::allocator<T>::deallocate(p, *reinterpret_cast<size_t*>(p) + count_elements);
+    }
+};
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -73,7 +234,6 @@ void do_test_comparison()
 {
     typedef typename const_string::value_type CharT;
     typedef std::basic_string<CharT> std_string;
-    using boost::cref;
     using boost::lit;
     
     CharT const(&empty)[1] = literals<CharT>::empty_string;
@@ -85,12 +245,12 @@ void do_test_comparison()
     const_string cs101;
     const_string cs102(empty);
     const_string cs103(empty, size_t(0));
-    const_string cs104(cref(empty));
-    const_string cs105(cref(empty), size_t(0));
+    const_string cs104(boost::cref(empty));
+    const_string cs105(boost::cref(empty), size_t(0));
     const_string cs106(some_string);
     const_string cs107(some_string, size_t(0));
-    const_string cs108(cref(some_string));
-    const_string cs109(cref(some_string), size_t(0));
+    const_string cs108(boost::cref(some_string));
+    const_string cs109(boost::cref(some_string), size_t(0));
     const_string cs110(lit(empty));
     const_string cs111(lit(some_string));
 
@@ -99,9 +259,9 @@ void do_test_comparison()
     const_string cs21(ss21);
     const_string cs22(ss21, 4);
     const_string cs23(ss21, 4, 2);
-    const_string cs24(cref(ss21));
-    const_string cs25(cref(ss21), 4);
-    const_string cs26(cref(ss21), 4, 2);
+    const_string cs24(boost::cref(ss21));
+    const_string cs25(boost::cref(ss21), 4);
+    const_string cs26(boost::cref(ss21), 4, 2);
 
     // from CharT const*
     CharT const* const cb(some_string);
@@ -110,21 +270,21 @@ void do_test_comparison()
 
     const_string cs301(b);
     const_string cs302(b, 10);
-    const_string cs303(cref(b));
-    const_string cs304(cref(b), 10);
-    const_string cs305(cref(cb));
-    const_string cs306(cref(cb), 10);
+    const_string cs303(boost::cref(b));
+    const_string cs304(boost::cref(b), 10);
+    const_string cs305(boost::cref(cb));
+    const_string cs306(boost::cref(cb), 10);
     const_string cs307(b, e);
-    const_string cs308(cref(b), e);
-    const_string cs309(cref(cb), e);
+    const_string cs308(boost::cref(b), e);
+    const_string cs309(boost::cref(cb), e);
 
     // from const_string
     const_string cs41(cs301);
     const_string cs42(cs301, 10);
     const_string cs43(cs301, 10, 10);
-    const_string cs44(cref(cs301));
-    const_string cs45(cref(cs301), 10);
-    const_string cs46(cref(cs301), 10, 10);
+    const_string cs44(boost::cref(cs301));
+    const_string cs45(boost::cref(cs301), 10);
+    const_string cs46(boost::cref(cs301), 10, 10);
 
     // other
     const_string xxx(3, 'x');
@@ -151,7 +311,7 @@ void do_test_comparison()
     BOOST_CHECK(b.begin() == b.end());
     BOOST_CHECK(b.rbegin() == b.rend());
 
-    const_string c(cref(empty));
+    const_string c(boost::cref(empty));
     BOOST_CHECK(c == empty);
     BOOST_CHECK(!(c != empty));
     BOOST_CHECK(!(c < empty));
@@ -162,11 +322,13 @@ void do_test_comparison()
     BOOST_CHECK(c.rbegin() == c.rend());
 
     c = empty;
-    c = cref(empty);
+    c = boost::cref(empty);
     c = const_string(empty);
-    c = cref(const_string(empty));
+    const_string const d(empty);
+    c = boost::cref(d);
     c = std_string(empty);
-    c = cref(std_string(empty));
+    std_string const e(empty);
+    c = boost::cref(e);
     }
 
     { // construction
@@ -187,7 +349,7 @@ void do_test_comparison()
         BOOST_CHECK(cs1 > cs1.ref_substr(0, cs1.size() - 1));
         BOOST_CHECK(cs1.ref_substr(0, cs1.size() - 1) < cs1);
 
-        const_string cs2(cref(ss1));
+        const_string cs2(boost::cref(ss1));
         BOOST_CHECK(cs2 == ss1);
         BOOST_CHECK(!(cs2 != ss1));
         BOOST_CHECK(!(cs2 < ss1));
@@ -206,7 +368,7 @@ void do_test_comparison()
         BOOST_CHECK(std::char_traits<CharT>::length(p1) == (size_t)std::distance(cs3.begin(), cs3.end()));
         BOOST_CHECK(std::char_traits<CharT>::length(p1) == (size_t)std::distance(cs3.rbegin(), cs3.rend()));
 
-        const_string cs4(cref(p1));
+        const_string cs4(boost::cref(p1));
         BOOST_CHECK(cs4 == p1);
         BOOST_CHECK(!(cs4 != p1));
         BOOST_CHECK(!(cs4 < p1));
@@ -227,12 +389,66 @@ void do_test_comparison()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
+template<class CharT>
+size_t c_str_length(CharT const* s)
+{
+    return std::char_traits<CharT>::length(s);
+}
+
+template<class const_string>
+void do_test_c_str()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    for(size_t n(1); n < 1000; n *= 3)
+    {
+        std_string const ss(gen_str<CharT>(n));
+
+        // characters with no trailing zero, reading past them is caught by address sanitizers
+        std::vector<CharT> chars(ss.begin(), ss.end());
+        CharT const* const p(&chars[0]);
+        const_string const ref(boost::cref(p), p + n);
+        BOOST_CHECK(ref.with_c_str(&c_str_length<CharT>) == n);
+        BOOST_CHECK(ref == ss);
+
+        const_string copy(ref);
+        BOOST_CHECK(copy.c_str() == ss);
+        BOOST_CHECK(c_str_length(copy.c_str()) == n);
+
+        // known to be terminated, c_str() neither copies nor reads past the end
+        const_string const s(ss);
+        const_string const suffix(s.ref_substr(n / 2));
+        BOOST_CHECK(suffix.c_str() == suffix.data());
+        BOOST_CHECK(suffix.with_c_str(&c_str_length<CharT>) == n - n / 2);
+        const_string const str_ref(boost::cref(ss));
+        BOOST_CHECK(str_ref.c_str() == str_ref.data());
+        CharT const* const zs(ss.c_str());
+        const_string const ptr_ref(boost::cref(zs));
+        BOOST_CHECK(ptr_ref.c_str() == ptr_ref.data());
+
+        const_string prefix(s.ref_substr(0, n - 1));
+        BOOST_CHECK(prefix.with_c_str(&c_str_length<CharT>) == n - 1);
+        BOOST_CHECK(prefix.c_str() == ss.substr(0, n - 1));
+    }
+
+    // a literal is terminated, whatever its length
+    typedef ::literals<CharT> literals;
+    const_string const literal(boost::cref(literals::some_string), c_str_length(literals::some_string));
+    BOOST_CHECK(literal.c_str() == literal.data());
+    BOOST_CHECK(boost::lit(literals::some_string).c_str() == literals::some_string);
+
+    const_string const empty;
+    BOOST_CHECK(empty.c_str() == empty.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
 template<class const_string>
 void do_test_basic_usage()
 {
     typedef typename const_string::value_type CharT;
     typedef std::basic_string<CharT> std_string;
-    using boost::cref;
 
     // swap, copy construction and assignment
     enum { N = 1024, M = 32 };
@@ -243,7 +459,7 @@ void do_test_basic_usage()
     {
         typename std::multiset<std_string>::const_iterator const i(original.insert(gen_str<CharT>(rand() % 256)));
         pretender_copy.push_back(*i);
-        pretender_ref.push_back(cref(*i));
+        pretender_ref.push_back(boost::cref(*i));
     }
     BOOST_CHECK(pretender_copy == pretender_ref);
     BOOST_CHECK(!(pretender_copy != pretender_ref));
@@ -288,7 +504,6 @@ void do_test_concatenation()
 {
     typedef typename const_string::value_type CharT;
     typedef std::basic_string<CharT> std_string;
-    using boost::cref;
 
     // concatenation
     std_string s1(gen_str<CharT>(8));
@@ -305,7 +520,7 @@ void do_test_concatenation()
     CharT const* const p8(s8.c_str());
 
     std_string const a1(s1 + p2 + s3 + p4 + s5 + p6 + s7 + p8);
-    const_string const b1((const_string(cref(s1))) + p2 + s3 + p4 + s5 + p6 + s7 + p8);
+    const_string const b1((const_string(boost::cref(s1))) + p2 + s3 + p4 + s5 + p6 + s7 + p8);
     BOOST_CHECK(a1 == b1);
 
     std_string a2;
@@ -359,7 +574,6 @@ void do_test_io()
 {
     typedef typename const_string::value_type CharT;
     typedef std::basic_string<CharT> std_string;
-    using boost::cref;
 
     // io quick and dirty test
     typedef std::basic_stringstream<CharT> stream;
@@ -376,40 +590,1671 @@ void do_test_io()
     s.clear();
     const_string c;
     getline(s, c);
-    BOOST_CHECK(const_string(cref(literals<CharT>::line), sizeof(literals<CharT>::line) / sizeof(*literals<CharT>::line) - 2) == c);
+    BOOST_CHECK(const_string(boost::cref(literals<CharT>::line), sizeof(literals<CharT>::line) / sizeof(*literals<CharT>::line) - 2) == c);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
-template class boost::const_string<char>;
-template class boost::const_string<wchar_t>;
+template<class const_string>
+void do_test_hash()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    boost::hash<const_string> const hasher;
+    for(size_t n(64); n--;)
+    {
+        std_string const ss(gen_str<CharT>(n));
+        const_string const cs1(ss);
+        const_string const cs2(boost::cref(ss));
+        const_string const twice(const_string(boost::cref(ss)) + ss);
+        const_string const cs3(twice.ref_substr(n));
+        BOOST_CHECK_EQUAL(hash_value(cs1), hasher(cs2));
+        BOOST_CHECK_EQUAL(hasher(cs1), hasher(cs3));
+    }
+    BOOST_CHECK(hasher(const_string(boost::cref(literals<CharT>::some_string))) != hasher(const_string(boost::cref(literals<CharT>::some_string), 35)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class const_string>
+void do_test_relocation()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    BOOST_STATIC_ASSERT(boost::cs::is_trivially_relocatable<const_string>::value);
+    BOOST_STATIC_ASSERT(boost::cs::is_trivially_relocatable<int>::value);
+    BOOST_STATIC_ASSERT(!boost::cs::is_trivially_relocatable<std_string>::value);
+
+    std::vector<std_string> model;
+    boost::const_string_vector<const_string> v;
+    for(size_t n(2048); n--;)
+    {
+        size_t const pos(model.empty() ? 0 : std::rand() % model.size());
+        switch(std::rand() % 8)
+        {
+        case 0:
+        case 1:
+        {
+            std_string const s(gen_str<CharT>(std::rand() % 32));
+            model.push_back(s);
+            v.push_back(s);
+            break;
+        }
+        case 2:
+        {
+            std_string const s(gen_str<CharT>(std::rand() % 32));
+            model.insert(model.begin() + pos, s);
+            v.insert(v.begin() + pos, s);
+            break;
+        }
+        case 3:
+            if(!model.empty())
+            {
+                // the inserted value is an element of the vector
+                model.insert(model.begin() + pos, 3, std_string(model.back()));
+                v.insert(v.begin() + pos, 3, v.back());
+            }
+            break;
+        case 4:
+        {
+            std::vector<std_string> const t(model.begin(), model.begin() + pos / 2);
+            model.insert(model.begin() + pos, t.begin(), t.end());
+            v.insert(v.begin() + pos, t.begin(), t.end());
+            break;
+        }
+        case 5:
+            if(!model.empty())
+            {
+                model.erase(model.begin() + pos);
+                v.erase(v.begin() + pos);
+            }
+            break;
+        case 6:
+            model.erase(model.begin() + pos / 2, model.begin() + pos);
+            v.erase(v.begin() + pos / 2, v.begin() + pos);
+            break;
+        case 7:
+        {
+            size_t const size(std::rand() % (2 * model.size() + 1));
+            model.resize(size, std_string(1, CharT('x')));
+            v.resize(size, const_string(1, CharT('x')));
+            break;
+        }
+        }
+        BOOST_REQUIRE_EQUAL(model.size(), v.size());
+        BOOST_CHECK(std::equal(model.begin(), model.end(), v.begin()));
+    }
+
+    boost::const_string_vector<const_string> w(v);
+    BOOST_CHECK(w == v);
+    w.erase(w.begin());
+    BOOST_CHECK(w != v);
+    swap(w, v);
+    BOOST_CHECK(std::equal(model.begin() + 1, model.end(), v.begin()));
+    std::reverse(v.begin(), v.end());
+    std::reverse(model.begin() + 1, model.end());
+    BOOST_CHECK(std::equal(model.begin() + 1, model.end(), v.begin()));
+    v.clear();
+    BOOST_CHECK(v.empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class const_string>
+void do_test_hash_map()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    std::map<std_string, int> model;
+    boost::const_string_map<int, const_string> m;
+    for(size_t n(4096); n--;)
+    {
+        // short strings to have both hits and misses
+        std_string const ss(gen_str<CharT>(1 + std::rand() % 3));
+        switch(std::rand() % 4)
+        {
+        case 0:
+            model[ss] = static_cast<int>(n);
+            m[ss.c_str()] = static_cast<int>(n);
+            break;
+        case 1:
+        {
+            bool const inserted(model.insert(std::make_pair(ss, 1)).second);
+            BOOST_CHECK_EQUAL(inserted, m.insert(std::make_pair(const_string(ss), 1)).second);
+            break;
+        }
+        case 2:
+            BOOST_CHECK_EQUAL(model.erase(ss), m.erase(ss));
+            break;
+        case 3:
+        {
+            typename std::map<std_string, int>::const_iterator const i(model.find(ss));
+            typename boost::const_string_map<int, const_string>::iterator const j(m.find(const_string(boost::cref(ss))));
+            BOOST_REQUIRE_EQUAL(i == model.end(), j == m.end());
+            if(j != m.end())
+            {
+                BOOST_CHECK(j->first == i->first);
+                BOOST_CHECK_EQUAL(j->second, i->second);
+                m.erase(j);
+                model.erase(ss);
+            }
+            break;
+        }
+        }
+        BOOST_REQUIRE_EQUAL(model.size(), m.size());
+    }
+
+    size_t found(0);
+    for(typename boost::const_string_map<int, const_string>::const_iterator i(m.begin()), e(m.end()); i != e; ++i, ++found)
+        BOOST_CHECK_EQUAL(model[i->first.str()], i->second);
+    BOOST_CHECK_EQUAL(found, m.size());
+
+    boost::const_string_map<int, const_string> m2(m);
+    m.clear();
+    BOOST_CHECK(m.empty());
+    BOOST_CHECK_EQUAL(m2.size(), model.size());
+
+    // heterogeneous lookups allocate no memory
+    std_string const ss(literals<CharT>::some_string);
+    const_string const parent(boost::cref(literals<CharT>::some_string));
+    boost::const_string_set<const_string> set;
+    set.insert_key(ss.substr(1, 20));
+    set.insert_key(ss.substr(2, 20).c_str());
+    allocation_count const before(allocation_count::now());
+    BOOST_CHECK(set.contains(ss.substr(1, 20)));
+    BOOST_CHECK(set.contains(parent.ref_substr(2, 20)));
+    BOOST_CHECK(!set.contains(parent.ref_substr(3, 20)));
+    BOOST_CHECK(!set.contains(literals<CharT>::some_string));
+    BOOST_CHECK_EQUAL(set.count(ss.substr(2, 20).c_str()), 1u);
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+    BOOST_CHECK(set.contains(std::basic_string_view<CharT>(literals<CharT>::some_string + 1, 20)));
+#endif
+    allocation_count const used(allocation_count::now() - before);
+    BOOST_CHECK_EQUAL(used.new_calls, 2u); // the two ss.substr()
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
 
+template<class const_string>
+void do_test_functional()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    std_string const ss(literals<CharT>::some_string);
+    const_string const parent(boost::cref(literals<CharT>::some_string));
+
+    boost::const_string_less<const_string> const less;
+    boost::const_string_equal_to<const_string> const equal_to;
+    boost::const_string_hash<const_string> const hash;
+    BOOST_CHECK(less(parent.ref_substr(0, 5), ss));
+    BOOST_CHECK(!less(ss, parent.ref_substr(0, 5)));
+    BOOST_CHECK(!less(ss.c_str(), parent));
+    BOOST_CHECK(less(ss.substr(0, 5).c_str(), ss.substr(1).c_str()));
+    BOOST_CHECK(equal_to(ss, parent));
+    BOOST_CHECK(equal_to(parent, ss.c_str()));
+    BOOST_CHECK(!equal_to(parent.ref_substr(1), ss));
+    BOOST_CHECK_EQUAL(hash(ss), boost::hash_value(parent));
+    BOOST_CHECK_EQUAL(hash(ss.c_str()), hash(parent));
+
+    typedef std::map<const_string, int, boost::const_string_less<const_string> > map;
+    map m;
+    for(int i(0); i != 16; ++i)
+        m[parent.substr(i, 8)] = i;
+
+    allocation_count const before(allocation_count::now());
+    for(int i(0); i != 16; ++i)
+    {
+        typename map::const_iterator const j(m.find(parent.ref_substr(i, 8)));
+        BOOST_REQUIRE(j != m.end());
+        BOOST_CHECK_EQUAL(j->second, i);
+    }
+    BOOST_CHECK(m.find(literals<CharT>::some_string) == m.end());
+#if defined(__cpp_lib_generic_associative_lookup)
+    // no const_string is made of the argument
+    BOOST_CHECK(m.find(ss) == m.end());
+    BOOST_CHECK_EQUAL(m.count(ss.c_str() + 16), 0u);
+    BOOST_CHECK_EQUAL((allocation_count::now() - before).new_calls, 0u);
+#endif
+
+#ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+    typedef std::basic_string_view<CharT> string_view;
+    string_view const sv(ss.data() + 2, 20);
+    BOOST_CHECK(m.find(sv.substr(0, 8)) != m.end());
+
+    const_string const copy(sv);
+    const_string const ref(boost::cref(sv), 1, 10);
+    BOOST_CHECK(copy.data() != sv.data());
+    BOOST_CHECK(ref.data() == sv.data() + 1);
+    BOOST_CHECK_EQUAL(ref.size(), 10u);
+    BOOST_CHECK(copy == sv);
+    BOOST_CHECK(sv == copy);
+    BOOST_CHECK(ref != sv);
+    BOOST_CHECK(ref < sv.substr(1));
+    BOOST_CHECK(sv.substr(1) >= ref);
+    BOOST_CHECK(sv.substr(1, 10) == ref);
+    BOOST_CHECK_THROW(const_string(sv, 21), std::out_of_range);
+
+    string_view const back = copy;
+    BOOST_CHECK(back.data() == copy.data());
+    BOOST_CHECK(back == sv);
+#endif // BOOST_NO_CXX17_HDR_STRING_VIEW
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class const_string>
+void do_test_prefix_storage()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    BOOST_STATIC_ASSERT(sizeof(const_string) == sizeof(boost::uint32_t) + 4 + sizeof(CharT*) || sizeof(CharT) > 4);
+    size_t const prefix_chars(const_string::storage_type::prefix_chars);
+
+    // long strings that share prefixes of all lengths around the one kept inline
+    std_string const base(gen_str<CharT>(3 * prefix_chars));
+    std::vector<std_string> sources;
+    for(size_t n(512); n--;)
+        sources.push_back(base.substr(0, std::rand() % base.size()) + gen_str<CharT>(std::rand() % 40));
+    std::vector<std_string> model(sources);
+    std::vector<const_string> v;
+    for(size_t i(0); i != sources.size(); ++i)
+        v.push_back(std::rand() % 2 ? const_string(sources[i]) : const_string(boost::cref(sources[i])));
+    std::sort(model.begin(), model.end());
+    std::sort(v.begin(), v.end());
+    BOOST_REQUIRE_EQUAL(model.size(), v.size());
+    for(size_t i(0); i != v.size(); ++i)
+    {
+        BOOST_CHECK(v[i] == model[i]);
+        if(i)
+        {
+            BOOST_CHECK_EQUAL(v[i - 1].compare(v[i]) <= 0, true);
+            BOOST_CHECK_EQUAL(v[i].compare(v[i - 1]) >= 0, true);
+            BOOST_CHECK_EQUAL(v[i - 1] == v[i], model[i - 1] == model[i]);
+        }
+    }
+
+    // the prefixes of strings whose characters are written after construction
+    const_string const a(base.begin(), base.end());
+    const_string const b(const_string(boost::cref(base)) + base);
+    const_string const c(base.size(), base[0]);
+    BOOST_CHECK(a < b);
+    BOOST_CHECK(b > a);
+    BOOST_CHECK(a.compare(b.ref_substr(0, base.size())) == 0);
+    BOOST_CHECK(c.compare(const_string(base.size(), base[0])) == 0);
+    BOOST_CHECK_EQUAL(c < a, std_string(base.size(), base[0]) < base);
+
+    // the empty string and a reference to an empty range compare equal
+    CharT const* const empty(literals<CharT>::some_string);
+    BOOST_CHECK(const_string() == const_string(boost::cref(empty), size_t(0)));
+    BOOST_CHECK(const_string() < a);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class const_string>
+void do_test_compact_storage()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    BOOST_STATIC_ASSERT(sizeof(const_string) == sizeof(CharT*));
+    size_t const buffer_chars(const_string::storage_type::effective_buffer_size_chars);
+
+    std_string const short_ss(gen_str<CharT>(buffer_chars - 1));
+    std_string const long_ss(gen_str<CharT>(4 * buffer_chars));
+    const_string const a(short_ss);
+    const_string const b(boost::cref(long_ss));
+    BOOST_CHECK(a == short_ss);
+    BOOST_CHECK(b == long_ss);
+    BOOST_CHECK(b.data() != long_ss.data()); // references are copies
+    BOOST_CHECK(!*a.end());
+    BOOST_CHECK(!*b.end());
+
+    const_string c(b);
+    BOOST_CHECK(c.data() == b.data());
+    c.make_immortal();
+    const_string d(c);
+    c = a;
+    BOOST_CHECK(d == b);
+    BOOST_CHECK(d.data() == b.data());
+    BOOST_CHECK_EQUAL(d.size(), long_ss.size());
+
+    boost::const_string_vector<const_string> v;
+    for(size_t n(0); n != 64; ++n)
+        v.push_back(n % 2 ? const_string(gen_str<CharT>(n)) : const_string(long_ss, n % long_ss.size()));
+    for(size_t n(0); n != 64; ++n)
+        BOOST_CHECK_EQUAL(v[n].size(), n % 2 ? n : long_ss.size() - n % long_ss.size());
+
+    boost::const_string_set<const_string> set;
+    for(size_t n(0); n != v.size(); ++n)
+        set.insert(v[n]);
+    for(size_t n(0); n != v.size(); ++n)
+        BOOST_CHECK(set.contains(v[n].str()));
+    BOOST_CHECK(!set.contains(long_ss.substr(1, 5)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class const_string>
+void do_test_sort(size_t n, unsigned threads)
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    // common prefixes longer than a key, embedded zeros and the characters
+    // of the highest and the lowest orders
+    std_string const base(gen_str<CharT>(20));
+    std::vector<std_string> model;
+    for(size_t i(n); i--;)
+    {
+        std_string ss(base.substr(0, std::rand() % base.size()) + gen_str<CharT>(std::rand() % 4));
+        if(!(std::rand() % 8))
+            ss += std::rand() % 2 ? CharT() : CharT(-1);
+        model.push_back(ss);
+    }
+
+    std::vector<const_string> v(model.begin(), model.end());
+    std::vector<std_string> ss(model);
+    std::sort(model.begin(), model.end());
+    allocation_count const before(allocation_count::now());
+    boost::sort_strings(v.begin(), v.end(), threads);
+    allocation_count const used(allocation_count::now() - before);
+    boost::sort_strings(ss.begin(), ss.end());
+
+    BOOST_CHECK_EQUAL(used.allocate_calls, 0u);
+    BOOST_CHECK_EQUAL(used.deallocate_calls, 0u);
+    BOOST_REQUIRE_EQUAL(v.size(), model.size());
+    BOOST_CHECK(std::equal(model.begin(), model.end(), v.begin()));
+    BOOST_CHECK(ss == model);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class const_string>
+void do_test_table()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+    typedef boost::const_string_table<const_string, counting_allocator<CharT> > table;
+
+    std::vector<std_string> model;
+    for(size_t n(4096); n--;)
+        model.push_back(gen_str<CharT>(std::rand() % 24));
+
+    allocation_count const before(allocation_count::now());
+    std::vector<const_string> kept;
+    {
+        table t(8192);
+        for(size_t i(0); i != model.size(); ++i)
+        {
+            const_string const s(t.push_back(model[i]));
+            BOOST_CHECK(s == model[i]);
+            BOOST_CHECK(!*s.end());
+        }
+        allocation_count const filled(allocation_count::now() - before);
+        BOOST_CHECK(filled.allocate_calls < model.size() / 64); // blocks and chunks of slices only
+        BOOST_CHECK_EQUAL(t.size(), model.size());
+        BOOST_CHECK(t.capacity_chars() >= model.size());
+
+        allocation_count const read_before(allocation_count::now());
+        for(size_t i(0); i != model.size(); ++i)
+        {
+            const_string s(t[i]);
+            const_string const c(s);
+            s = t.at(i);
+            BOOST_CHECK(c == model[i]);
+            BOOST_CHECK(c.data() == t[i].data());
+            BOOST_CHECK(s.c_str() == c.data());
+        }
+        allocation_count const read(allocation_count::now() - read_before);
+        BOOST_CHECK_EQUAL(read.allocate_calls, 0u);
+        BOOST_CHECK_EQUAL(read.new_calls, 0u);
+        BOOST_CHECK_THROW(t.at(t.size()), std::out_of_range);
+
+        kept.push_back(t[7]);
+        kept.push_back(t.back().ref_substr(1));
+        kept.back().make_immortal(); // keeps the characters alive for good
+        kept.push_back(t.push_back(literals<CharT>::some_string));
+    }
+
+    // the strings outlive the table
+    BOOST_CHECK(kept[0] == model[7]);
+    BOOST_CHECK(kept[2] == literals<CharT>::some_string);
+    allocation_count const alive(allocation_count::now() - before);
+    BOOST_CHECK(alive.deallocate_calls < alive.allocate_calls);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+// counts the release calls of the buffers adopted by strings
 template<class CharT>
-void do_unit_test()
+struct adopted_buffers
 {
-    do_test_comparison<boost::const_string<CharT> >();
-    do_test_basic_usage<boost::const_string<CharT> >();
-    do_test_concatenation<boost::const_string<CharT> >();
-    do_test_format<boost::const_string<CharT> >();
-    do_test_io<boost::const_string<CharT> >();
+    size_t released;
+    CharT const* data;
+    size_t size;
+
+    static void release(void* context, CharT const* data, size_t size)
+    {
+        adopted_buffers* const self(static_cast<adopted_buffers*>(context));
+        ++self->released;
+        self->data = data;
+        self->size = size;
+    }
+};
+
+template<class const_string>
+void do_test_adopt()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    std_string const model(gen_str<CharT>(100));
+    std::vector<CharT> buffer(model.begin(), model.end());
+    buffer.push_back(CharT());
+    adopted_buffers<CharT> buffers = { 0, 0, 0 };
+
+    const_string kept;
+    {
+        allocation_count const before(allocation_count::now());
+        const_string const s(const_string::adopt(&buffer[0], model.size(), &adopted_buffers<CharT>::release, &buffers));
+        BOOST_CHECK_EQUAL((allocation_count::now() - before).allocate_calls, 0u); // no copy of the characters
+        BOOST_CHECK(s == model);
+        BOOST_CHECK(s.data() == &buffer[0]);
+        BOOST_CHECK(s.with_c_str(&c_str_length<CharT>) == model.size()); // may have no trailing zero
+        BOOST_CHECK(s.data() == &buffer[0]);
+
+        const_string const c(s);
+        BOOST_CHECK(c.data() == &buffer[0]);
+        BOOST_CHECK(s.ref_substr(10, 20).data() == &buffer[10]);
+        kept = c;
+        BOOST_CHECK(s.substr(1) == model.substr(1));
+        BOOST_CHECK_EQUAL(buffers.released, 0u);
+    }
+    BOOST_CHECK_EQUAL(buffers.released, 0u); // kept refers to the buffer
+    BOOST_CHECK(kept == model);
+
+    kept = const_string();
+    BOOST_CHECK_EQUAL(buffers.released, 1u);
+    BOOST_CHECK(buffers.data == &buffer[0]);
+    BOOST_CHECK_EQUAL(buffers.size, model.size());
+
+    // an immortal copy never releases it
+    adopted_buffers<CharT> immortal = { 0, 0, 0 };
+    const_string s(const_string::adopt(&buffer[0], model.size(), &adopted_buffers<CharT>::release, &immortal));
+    s.make_immortal();
+    s = const_string();
+    BOOST_CHECK_EQUAL(immortal.released, 0u);
+
+    // no release function
+    BOOST_CHECK(const_string::adopt(&buffer[0], 5, 0) == model.substr(0, 5));
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    // a long std::basic_string<> is moved in, short ones and ones with much slack are copied
+    std_string long_string(gen_str<CharT>(1000));
+    std_string const long_copy(long_string);
+    CharT const* const long_data(long_string.data());
+    const_string const moved(std::move(long_string));
+    BOOST_CHECK(moved == long_copy);
+    BOOST_CHECK(moved.data() == long_data);
+    BOOST_CHECK(moved.c_str() == long_data);
+    const_string adopted;
+    adopted = std_string(long_copy);
+    BOOST_CHECK(adopted == long_copy);
+
+    std_string short_string(model.substr(0, 10));
+    CharT const* const short_data(short_string.data());
+    const_string const copied(std::move(short_string));
+    BOOST_CHECK(copied == model.substr(0, 10));
+    BOOST_CHECK(copied.data() != short_data);
+
+    std_string slack(long_copy);
+    slack.reserve(10000);
+    CharT const* const slack_data(slack.data());
+    const_string const trimmed(std::move(slack));
+    BOOST_CHECK(trimmed == long_copy);
+    BOOST_CHECK(trimmed.data() != slack_data);
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
-BOOST_AUTO_UNIT_TEST(constant_string_regression_char)
+template<class const_string>
+void do_test_dedup()
 {
-    std::srand(0);
-    do_unit_test<char>();
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    size_t const buffer_chars(const_string::storage_type::effective_buffer_size_chars);
+    std::vector<std_string> values;
+    for(size_t n(64); n--;)
+        values.push_back(gen_str<CharT>(buffer_chars + std::rand() % 32));
+
+    { // repeats share the first copy, no memory is allocated for them
+    boost::dedup_loader<const_string> loader(1 << 20);
+    std::vector<const_string> loaded;
+    for(size_t i(0); i != values.size(); ++i)
+        loaded.push_back(loader(values[i]));
+    BOOST_CHECK_EQUAL(loader.size(), values.size());
+    BOOST_CHECK_EQUAL(loader.misses(), values.size());
+
+    allocation_count const before(allocation_count::now());
+    for(size_t n(1024); n--;)
+    {
+        size_t const i(std::rand() % values.size());
+        const_string const s(loader(values[i]));
+        BOOST_CHECK(s == values[i]);
+        BOOST_CHECK(s.data() == loaded[i].data());
+    }
+    BOOST_CHECK_EQUAL((allocation_count::now() - before).allocate_calls, 0u);
+    BOOST_CHECK_EQUAL(loader.hits(), 1024u);
+
+    std_string const short_ss(gen_str<CharT>(buffer_chars - 1));
+    BOOST_CHECK(loader(short_ss) == short_ss);
+    BOOST_CHECK_EQUAL(loader.size(), values.size()); // not kept
+    }
+
+    { // the budget is never exceeded, the strings loaded often stay
+    boost::dedup_loader<const_string> loader(2048);
+    const_string const hot(loader(values[0]));
+    for(size_t n(4096); n--;)
+    {
+        size_t const i(std::rand() % values.size());
+        BOOST_CHECK(loader(values[i]) == values[i]);
+        BOOST_CHECK(loader(values[0]).data() == hot.data());
+        BOOST_CHECK(loader.memory() <= loader.budget());
+    }
+    BOOST_CHECK(loader.size() < values.size());
+    BOOST_CHECK(loader.hits() > 4096u);
+    loader.clear();
+    BOOST_CHECK_EQUAL(loader.size(), 0u);
+    BOOST_CHECK_EQUAL(loader.memory(), 0u);
+
+    boost::dedup_loader<const_string> tiny(1);
+    BOOST_CHECK(tiny(values[1]) == values[1]);
+    BOOST_CHECK_EQUAL(tiny.size(), 0u);
+    }
 }
 
-#ifndef BOOST_NO_CWCHAR
+////////////////////////////////////////////////////////////////////////////////////////////////
 
-BOOST_AUTO_UNIT_TEST(constant_string_regression_wchar_t)
+template<class const_string>
+void do_test_pool_allocator()
 {
-    std::srand(1);
-    do_unit_test<wchar_t>();
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    std::vector<std_string> model;
+    for(size_t n(2048); n--;)
+        model.push_back(gen_str<CharT>(16 + std::rand() % 300));
+
+    // blocks are reused after they are freed
+    std::vector<const_string> v(model.begin(), model.end());
+    for(size_t n(8); n--;)
+    {
+        for(size_t i(0); i != v.size(); i += 2)
+            v[i] = const_string();
+        for(size_t i(0); i != v.size(); i += 2)
+            v[i] = model[i];
+    }
+    BOOST_CHECK(std::equal(model.begin(), model.end(), v.begin()));
+
+#if defined(BOOST_CONST_STRING_POOL) && !defined(BOOST_NO_CXX11_HDR_THREAD)
+    // blocks allocated on one thread are freed on another and reused there, threads come and go
+    for(int round(0); round != 4; ++round)
+    {
+        std::vector<const_string> produced[4];
+        std::vector<std::thread> threads;
+        for(int t(0); t != 4; ++t)
+            threads.push_back(std::thread([&model, &produced, t] {
+                for(size_t i(t); i < model.size(); i += 4)
+                    produced[t].push_back(const_string(model[i]));
+            }));
+        for(size_t t(0); t != threads.size(); ++t)
+            threads[t].join();
+        threads.clear();
+
+        size_t mismatches[4] = { 0, 0, 0, 0 }; // Boost.Test checks are not thread safe
+        for(int t(0); t != 4; ++t)
+            threads.push_back(std::thread([&model, &produced, &mismatches, t] {
+                std::vector<const_string>& mine(produced[(t + 1) % 4]);
+                for(size_t i(0); i != mine.size(); ++i)
+                {
+                    mismatches[t] += mine[i] != model[i * 4 + (t + 1) % 4];
+                    mine[i] = const_string();
+                    const_string const s(model[i]);
+                    mine[i] = s;
+                }
+            }));
+        for(size_t t(0); t != threads.size(); ++t)
+        {
+            threads[t].join();
+            BOOST_CHECK_EQUAL(mismatches[t], 0u);
+        }
+        for(int t(0); t != 4; ++t)
+            for(size_t i(0); i != produced[t].size(); ++i)
+                BOOST_CHECK(produced[t][i] == model[i]);
+    }
+#endif
 }
 
-#endif // BOOST_NO_CWCHAR
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class const_string>
+void do_test_atomic()
+{
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_HDR_MUTEX) && !defined(BOOST_NO_CXX11_HDR_THREAD)
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    boost::atomic_const_string<const_string> a;
+    BOOST_CHECK(a.load().empty());
+    std_string const s1(gen_str<CharT>(100)), s2(gen_str<CharT>(3));
+    a.store(s1);
+    BOOST_CHECK(a.load() == s1);
+    BOOST_CHECK(a.exchange(s2) == s1);
+    const_string expected(s1);
+    BOOST_CHECK(!a.compare_exchange_strong(expected, s1));
+    BOOST_CHECK(expected == s2);
+    BOOST_CHECK(a.compare_exchange_strong(expected, s1));
+    BOOST_CHECK(static_cast<const_string>(a) == s1);
+
+    // readers see whole values while a writer replaces them, a value is a size repeated
+    enum { readers = 4, values = 2000 };
+    a = const_string(1, CharT('b'));
+    std::atomic<bool> done(false);
+    std::atomic<int> started(0);
+    size_t mismatches[readers] = { 0 }; // Boost.Test checks are not thread safe
+    std::vector<std::thread> threads;
+    for(int t(0); t != readers; ++t)
+        threads.push_back(std::thread([&a, &done, &started, &mismatches, t] {
+            for(bool first(true); first || !done.load(); first = false)
+            {
+                const_string const s(a.load());
+                mismatches[t] += CharT(s.size() % 26 + 'a') != s[0] || s != const_string(s.size(), s[0]);
+                if(first)
+                    ++started;
+            }
+        }));
+    while(started.load() != readers)
+        std::this_thread::yield();
+    for(size_t n(2); n != values; ++n)
+        a = const_string(n, CharT(n % 26 + 'a'));
+    done = true;
+    for(int t(0); t != readers; ++t)
+    {
+        threads[t].join();
+        BOOST_CHECK_EQUAL(mismatches[t], 0u);
+    }
+    BOOST_CHECK(a.load() == const_string(values - 1, CharT((values - 1) % 26 + 'a')));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class const_string>
+void do_test_intern()
+{
+#if !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_HDR_MUTEX) \
+    && !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+    typedef boost::concurrent_intern_table<const_string> table;
+
+    std::vector<std_string> model;
+    for(size_t n(3000); n--;)
+        model.push_back(gen_str<CharT>(8 + n % 40));
+
+    {
+        table t(4);
+        const_string const s(model[0]);
+        BOOST_CHECK(t.get_or_insert(s).data() == s.data()); // shares the block of the argument
+        BOOST_CHECK(t.get_or_insert(model[0]).data() == s.data());
+        for(size_t i(0); i != model.size(); ++i)
+            BOOST_CHECK(t.get_or_insert(model[i]) == model[i]);
+        BOOST_CHECK_EQUAL(t.size(), model.size());
+
+        // the strings not interned between two collections are forgotten
+        BOOST_CHECK_EQUAL(t.collect(), 0u);
+        const_string const kept(t.get_or_insert(model[1]));
+        BOOST_CHECK_EQUAL(t.collect(), model.size() - 1);
+        BOOST_CHECK_EQUAL(t.size(), 1u);
+        BOOST_CHECK(t.get_or_insert(model[1]).data() == kept.data());
+        BOOST_CHECK(s == model[0]); // outlives its entry
+        BOOST_CHECK(t.get_or_insert(model[0]).data() != s.data());
+    }
+
+    { // the characters of a reference are copied, the table outlives them
+        table t;
+        std::vector<CharT>* const buffer(new std::vector<CharT>(model[2].begin(), model[2].end()));
+        CharT const* const p(&(*buffer)[0]);
+        const_string const interned(t.get_or_insert(const_string(boost::cref(p), p + buffer->size())));
+        BOOST_CHECK(interned.data() != p);
+        delete buffer; // address sanitizers catch a table still pointing into it
+        BOOST_CHECK(t.get_or_insert(model[2]).data() == interned.data());
+        BOOST_CHECK(interned == model[2]);
+
+        const_string const s(model[3]);
+        BOOST_CHECK(t.get_or_insert(s.ref_substr(1)).data() != s.data() + 1);
+        BOOST_CHECK(t.get_or_insert(s).data() == s.data());
+    }
+
+    // the threads get the same copies while another one collects
+    enum { threads = 4 };
+    for(int collecting(0); collecting != 2; ++collecting)
+    {
+        table t;
+        std::vector<std::vector<CharT const*> > seen(threads);
+        std::atomic<bool> done(false);
+        size_t mismatches[threads] = { 0 }; // Boost.Test checks are not thread safe
+        std::vector<std::thread> workers;
+        for(int i(0); i != threads; ++i)
+            workers.push_back(std::thread([&t, &model, &seen, &mismatches, i] {
+                for(size_t j(0); j != model.size(); ++j)
+                {
+                    size_t const k((j * (i + 1) * 7) % model.size());
+                    const_string const s(t.get_or_insert(model[k]));
+                    mismatches[i] += s != model[k];
+                }
+                for(size_t j(0); j != model.size(); ++j)
+                    seen[i].push_back(t.get_or_insert(model[j]).data());
+            }));
+        std::thread collector;
+        if(collecting)
+            collector = std::thread([&t, &done] {
+                while(!done.load())
+                    t.collect();
+            });
+        for(int i(0); i != threads; ++i)
+        {
+            workers[i].join();
+            BOOST_CHECK_EQUAL(mismatches[i], 0u);
+        }
+        done = true;
+        if(collecting)
+            collector.join();
+        else
+            for(int i(1); i != threads; ++i)
+                BOOST_CHECK(seen[i] == seen[0]);
+    }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the fields of s separated by any of the delimiters, empty ones skipped when tokenizing
+template<class CharT>
+std::vector<std::basic_string<CharT> > model_split(std::basic_string<CharT> const& s, std::basic_string<CharT> const& delimiters, bool tokenize)
+{
+    std::vector<std::basic_string<CharT> > fields;
+    size_t first(0);
+    for(;;)
+    {
+        size_t const last(s.find_first_of(delimiters, first));
+        std::basic_string<CharT> const field(s.substr(first, last - first));
+        if(!tokenize || !field.empty())
+            fields.push_back(field);
+        if(last == std::basic_string<CharT>::npos)
+            return fields;
+        first = last + 1;
+    }
+}
+
+template<class const_string>
+void do_test_split()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    CharT const delimiters[] = { ',', ' ', '\t', 0 };
+    for(size_t n(0); n < 300; n += 1 + n / 8)
+    {
+        std_string ss(gen_str<CharT>(n));
+        for(size_t i(0); i < n; i += 1 + std::rand() % 20)
+            ss[i] = delimiters[std::rand() % 3];
+        const_string const s(ss);
+
+        std::vector<std_string> const fields(model_split(ss, std_string(1, delimiters[0]), false));
+        std::vector<const_string> split(boost::split(s, delimiters[0]).begin(), boost::split(s, delimiters[0]).end());
+        BOOST_CHECK(split.size() == fields.size() && std::equal(fields.begin(), fields.end(), split.begin()));
+
+        std::vector<std_string> const tokens(model_split(ss, std_string(delimiters), true));
+        std::vector<const_string> tokenized;
+        typedef boost::field_range<const_string, boost::cs::aux::set_finder<const_string> > range;
+        range const r(boost::tokenize(s, delimiters));
+        for(typename range::iterator i(r.begin()), e(r.end()); i != e; ++i)
+        {
+            tokenized.push_back(*i);
+            // the fields of a long string refer to it
+            BOOST_CHECK(i->size() < const_string::storage_type::effective_buffer_size_chars
+                || (i->data() >= s.data() && i->data() < s.data() + s.size()));
+        }
+        BOOST_CHECK(tokenized.size() == tokens.size() && std::equal(tokens.begin(), tokens.end(), tokenized.begin()));
+    }
+
+    // fields of a string stored inside a const_string take no allocation either
+    const_string const s(literals<CharT>::some_string, 4);
+    allocation_count const before(allocation_count::now());
+    size_t n(0);
+    typedef boost::field_range<const_string, boost::cs::aux::char_finder<const_string> > range;
+    range const r(boost::split(s, s[1]));
+    for(typename range::iterator i(r.begin()), e(r.end()); i != e; ++i)
+        n += i->size() + 1;
+    BOOST_CHECK_EQUAL(n, s.size() + 1);
+    BOOST_CHECK_EQUAL((allocation_count::now() - before).allocate_calls, 0u);
+}
+
+template<class T>
+struct first_greater
+{
+    bool operator()(T const& a, T const& b) const { return a.first > b.first; }
+};
+
+// a string of the characters a, b and c, and one with the low byte of a when CharT is wider
+template<class CharT>
+std::basic_string<CharT> gen_abc(size_t n)
+{
+    CharT const abc[] = { 'a', 'b', 'c', CharT(0x161) };
+    std::basic_string<CharT> r(n, CharT());
+    while(n--)
+        r[n] = abc[std::rand() % 4];
+    return r;
+}
+
+// ASCII letters compare case insensitively
+template<class CharT>
+struct nocase_traits : std::char_traits<CharT>
+{
+    static CharT fold(CharT c) { return c >= 'A' && c <= 'Z' ? CharT(c - 'A' + 'a') : c; }
+    static bool eq(CharT a, CharT b) { return fold(a) == fold(b); }
+    static bool lt(CharT a, CharT b) { return fold(a) < fold(b); }
+
+    static int compare(CharT const* a, CharT const* b, size_t n)
+    {
+        for(; n--; ++a, ++b)
+            if(!eq(*a, *b))
+                return lt(*a, *b) ? -1 : 1;
+        return 0;
+    }
+
+    static CharT const* find(CharT const* s, size_t n, CharT c)
+    {
+        for(; n--; ++s)
+            if(eq(*s, c))
+                return s;
+        return 0;
+    }
+};
+
+template<class const_string>
+void do_test_searcher()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+    typedef boost::const_string_searcher<const_string> searcher;
+
+    for(size_t n(0); n < 400; n += 1 + n / 4)
+    {
+        std_string const ss(gen_abc<CharT>(n));
+        const_string const s(ss);
+        for(size_t m(0); m != 12; ++m)
+        {
+            // a needle taken from the haystack or made up
+            std_string const needle(std::rand() % 2 && m <= n ? ss.substr(std::rand() % (n - m + 1), m) : gen_abc<CharT>(m));
+            searcher const f((const_string(needle)));
+
+            std::vector<size_t> model;
+            for(size_t i(ss.find(needle)); i != std_string::npos && i <= n; i = ss.find(needle, i + (m ? m : 1)))
+                model.push_back(i);
+            std::vector<size_t> found;
+            f.find_all(s, std::back_inserter(found));
+            BOOST_CHECK(found == model);
+            BOOST_CHECK_EQUAL(f.count(s), model.size());
+
+            size_t const pos(std::rand() % (n + 2));
+            BOOST_CHECK_EQUAL(f.find(s, pos), ss.find(needle, pos));
+            BOOST_CHECK_EQUAL(s.find(const_string(needle), pos), ss.find(needle, pos));
+#if defined(__cpp_lib_boyer_moore_searcher)
+            BOOST_CHECK(std::search(s.begin(), s.end(), f) - s.begin() == static_cast<std::ptrdiff_t>(model.empty() ? n : model[0]));
+#endif
+        }
+    }
+
+    // the traits are honoured by needles of any length
+    typedef nocase_traits<CharT> nocase;
+    typedef boost::const_string<CharT, nocase, boost::const_string_storage<nocase> > nocase_string;
+    for(size_t m(1); m != 20; ++m)
+    {
+        std_string const needle(gen_abc<CharT>(m));
+        std_string ss(gen_abc<CharT>(200));
+        ss.replace(150, m, needle);
+        for(size_t i(0); i != ss.size(); ++i)
+            if(std::rand() % 2)
+                ss[i] = CharT(ss[i] == 'a' ? 'A' : ss[i] == 'b' ? 'B' : ss[i]);
+        size_t model(0);
+        while(nocase::compare(ss.data() + model, needle.data(), m))
+            ++model;
+        boost::const_string_searcher<nocase_string> const f(nocase_string(needle.data(), m));
+        BOOST_CHECK_EQUAL(f.find(nocase_string(ss.data(), ss.size())), model);
+    }
+}
+
+template<class const_string>
+void do_test_multi_pattern()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+    typedef boost::multi_pattern_matcher<const_string> matcher;
+    typedef std::pair<size_t, size_t> position_pattern;
+
+    for(size_t n(0); n != 40; ++n)
+    {
+        // patterns that overlap, repeat and are suffixes of each other, an empty one included
+        std::vector<const_string> patterns;
+        for(size_t i(0); i != n; ++i)
+            patterns.push_back(const_string(gen_abc<CharT>(i % 7)));
+        if(n > 3)
+            patterns.push_back(patterns[3]);
+        matcher const m(patterns.begin(), patterns.end());
+        BOOST_CHECK_EQUAL(m.patterns(), patterns.size());
+
+        for(size_t size(0); size < 500; size += 1 + size)
+        {
+            std_string const ss(gen_abc<CharT>(size));
+            const_string const s(ss);
+
+            std::vector<position_pattern> model;
+            for(size_t p(0); p != patterns.size(); ++p)
+                if(!patterns[p].empty())
+                    for(size_t i(ss.find(patterns[p].data(), 0, patterns[p].size())); i != std_string::npos; i = ss.find(patterns[p].data(), i + 1, patterns[p].size()))
+                        model.push_back(position_pattern(i + patterns[p].size(), p));
+            std::sort(model.begin(), model.end());
+
+            std::vector<typename matcher::match> matches;
+            m.find_all(s, std::back_inserter(matches));
+            std::vector<position_pattern> found;
+            for(size_t i(0); i != matches.size(); ++i)
+                found.push_back(position_pattern(matches[i].position + patterns[matches[i].pattern].size(), matches[i].pattern));
+            // reported by the end position
+            BOOST_CHECK(std::adjacent_find(found.begin(), found.end(), first_greater<position_pattern>()) == found.end());
+            std::sort(found.begin(), found.end());
+            BOOST_CHECK(found == model);
+            BOOST_CHECK_EQUAL(m.count(s), model.size());
+            BOOST_CHECK_EQUAL(m.contains(s), !model.empty());
+        }
+    }
+}
+
+template<class CharT>
+struct chunk_appender
+{
+    std::basic_string<CharT>* s;
+    void operator()(CharT const* data, size_t size) const { s->append(data, size); }
+};
+
+template<class const_string>
+void do_test_rope()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+    typedef boost::const_rope<const_string> rope;
+
+    BOOST_CHECK(rope().empty() && rope(const_string()).empty() && rope().flatten().empty());
+
+    rope r;
+    std_string model;
+    for(size_t i(0); i != 3000; ++i)
+    {
+        std_string const piece(gen_str<CharT>(std::rand() % 300));
+        switch(std::rand() % 4)
+        {
+        case 0:
+            r = const_string(piece) + r;
+            model = piece + model;
+            break;
+        case 1:
+            {
+                // cut out the middle
+                size_t const pos(std::rand() % (model.size() + 1));
+                size_t const n(std::rand() % (model.size() - pos + 1));
+                r = r.substr(0, pos) + r.substr(pos + n);
+                model.erase(pos, n);
+            }
+            break;
+        default:
+            r += const_string(piece);
+            model += piece;
+        }
+        BOOST_REQUIRE_EQUAL(r.size(), model.size());
+        if(!model.empty())
+        {
+            size_t const index(std::rand() % model.size());
+            BOOST_CHECK(r[index] == model[index] && r.at(index) == model[index]);
+        }
+    }
+    BOOST_CHECK(r.flatten() == model);
+    BOOST_CHECK_THROW(r.at(model.size()), std::out_of_range);
+    BOOST_CHECK_THROW(r.substr(model.size() + 1), std::out_of_range);
+    BOOST_CHECK(r.substr(model.size()).empty());
+
+    // balanced
+    size_t leaves(0);
+    for(size_t n(r.size()); n; n /= 2)
+        ++leaves;
+    BOOST_CHECK(r.depth() <= 2 * leaves);
+
+    std_string chunks;
+    chunk_appender<CharT> const a = { &chunks };
+    r.for_each_chunk(a);
+    BOOST_CHECK(chunks == model);
+    std::basic_ostringstream<CharT> os;
+    os << r.substr(10, 1000);
+    BOOST_CHECK(os.str() == model.substr(10, 1000));
+
+    // long pieces are shared, not copied
+    const_string const s(gen_str<CharT>(1000));
+    BOOST_CHECK(rope(s).flatten().data() == s.data());
+    allocation_count const before(allocation_count::now());
+    rope const t(rope(s).substr(100, 300) + s.substr(0, 0) + rope(s).substr(500));
+    BOOST_CHECK_EQUAL((allocation_count::now() - before).allocate_calls, 0u);
+    BOOST_CHECK(t.flatten() == const_string(s.substr(100, 300) + s.substr(500)));
+}
+
+#ifdef BOOST_HAS_UNISTD_H
+
+// reads what is available, the descriptor doesn't block
+template<class CharT>
+void read_available(int fd, std::basic_string<CharT>& to)
+{
+    std::vector<char> bytes;
+    char buffer[4096];
+    for(ssize_t r; (r = ::read(fd, buffer, sizeof buffer)) > 0;)
+        bytes.insert(bytes.end(), buffer, buffer + r);
+    BOOST_REQUIRE(bytes.size() % sizeof(CharT) == 0);
+    if(!bytes.empty())
+        to.append(reinterpret_cast<CharT const*>(&bytes[0]), bytes.size() / sizeof(CharT));
+}
+
+#endif // BOOST_HAS_UNISTD_H
+
+template<class const_string>
+void do_test_gather()
+{
+#ifdef BOOST_HAS_UNISTD_H
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+    typedef boost::gather_writer<const_string> writer;
+
+    // more pieces than a call takes and more bytes than a pipe holds, short ones and long ones
+    writer w;
+    std_string model;
+    for(size_t i(0); i != 3000; ++i)
+    {
+        std_string const ss(gen_str<CharT>(i % 5 ? i % 7 : 100 + i % 300));
+        if(i % 3)
+        {
+            w << const_string(ss);
+            model += ss;
+        }
+        else
+        {
+            // the writer keeps the temporary strings of the expression
+            w << const_string(ss) + literals<CharT>::some_string + const_string(ss);
+            model += ss + literals<CharT>::some_string + ss;
+        }
+    }
+    BOOST_CHECK_EQUAL(w.size(), model.size() * sizeof(CharT));
+
+    int fds[2];
+    BOOST_REQUIRE(0 == ::pipe(fds));
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    std_string received;
+    size_t calls(0);
+    for(; !w.write_to(fds[1]); ++calls)
+        read_available(fds[0], received); // the pipe was full, partial writes are resumed
+    read_available(fds[0], received);
+    BOOST_CHECK(calls > 0);
+    BOOST_CHECK(w.empty());
+    BOOST_CHECK(received == model);
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    BOOST_REQUIRE(0 == ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    const_string const a(gen_str<CharT>(50)), b(gen_str<CharT>(5));
+    BOOST_CHECK(w.append(a + b).append(a).send_to(fds[1]));
+    received.clear();
+    read_available(fds[0], received);
+    BOOST_CHECK(received == std_string(a.data(), a.size()) + std_string(b.data(), b.size()) + std_string(a.data(), a.size()));
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    BOOST_CHECK_THROW(writer().append(a).write_to(-1), std::runtime_error);
+#endif
+}
+
+template<class const_string>
+void do_test_split_lines()
+{
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+    typedef boost::const_string_lines<const_string> lines_type;
+
+    for(size_t n(0); n < 3000; n += 1 + n / 4)
+    {
+        std_string ss(gen_str<CharT>(n));
+        for(size_t i(std::rand() % 40); i < n; i += 1 + std::rand() % (i % 3 ? 40 : 2))
+            ss[i] = '\n';
+        std::vector<std_string> model(model_split(ss, std_string(1, '\n'), false));
+        if(model.back().empty())
+            model.pop_back(); // no line after the last newline
+
+        for(unsigned threads(1); threads != 6; ++threads)
+        {
+            // the lines keep the string alive
+            lines_type const lines(boost::split_lines_parallel(const_string(ss), threads, 1));
+            const_string const& s(lines.str());
+            BOOST_CHECK(lines.size() == model.size() && std::equal(model.begin(), model.end(), lines.begin()));
+            for(size_t i(0); i != lines.size(); ++i)
+                BOOST_CHECK(lines[i].size() < const_string::storage_type::effective_buffer_size_chars
+                    || (lines[i].data() >= s.data() && lines[i].data() < s.data() + s.size()));
+        }
+    }
+
+    // a short string is split on the calling thread
+    const_string const s(literals<CharT>::some_string);
+    lines_type const lines(s);
+    BOOST_CHECK_EQUAL(lines.size(), 1u);
+    BOOST_CHECK(lines.at(0) == s);
+    BOOST_CHECK_THROW(lines.at(1), std::out_of_range);
+    BOOST_CHECK(lines_type(const_string()).empty());
+
+    // and so does a line that outlives them
+    std_string const ss(gen_str<CharT>(100) + CharT('\n'));
+    const_string const line(lines_type(const_string(ss + ss), 2, 1)[1]);
+    BOOST_CHECK(line == ss.substr(0, 100));
+#endif
+}
+
+template<class const_string>
+void do_test_parallel_find()
+{
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_HDR_ATOMIC) && !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+
+    for(size_t n(0); n < 3000; n += 1 + n / 2)
+    {
+        std_string const ss(gen_abc<CharT>(n));
+        const_string const s(ss);
+        for(size_t m(0); m < 12; m += 1 + m / 4)
+        {
+            std_string const needle(gen_abc<CharT>(m));
+            size_t overlapping(0);
+            for(size_t i(ss.find(needle)); i != std_string::npos; i = ss.find(needle, i + 1))
+                ++overlapping;
+            for(unsigned threads(1); threads != 6; ++threads)
+            {
+                size_t const pos(std::rand() % (n + 2));
+                BOOST_CHECK_EQUAL(boost::parallel_find(s, const_string(needle), pos, threads, 1), ss.find(needle, pos));
+                BOOST_CHECK_EQUAL(boost::parallel_count(s, const_string(needle), threads, 1), overlapping);
+            }
+        }
+    }
+
+    // the chunks after the first occurrence give up
+    std_string ss(3000000, CharT('a'));
+    ss[ss.size() - 1] = 'b';
+    ss[1000] = 'b';
+    const_string const s(ss);
+    BOOST_CHECK_EQUAL(boost::parallel_find(s, const_string(ss.substr(990, 11)), 0, 4), 990u);
+    BOOST_CHECK_EQUAL(boost::parallel_find(s, const_string(ss.substr(990, 11)), 991, 4), ss.size() - 11);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the number of blocks cs_format() allocates for a result of the given length:
+// the inline buffer is tried first, then the hint is doubled until the result fits
+// one per size tried, and one more when the characters are moved to a block of their size,
+// which takes fewer elements of element_chars characters, see set_size()
+size_t expected_format_allocations(size_t buffer_chars, size_t hint, size_t length, size_t element_chars)
+{
+    size_t n(0);
+    ++hint;
+    if(hint <= buffer_chars)
+    {
+        if(length < buffer_chars)
+            return n;
+        hint = 2 * buffer_chars;
+    }
+    for(; true; hint *= 2)
+    {
+        ++n;
+        if(length < hint)
+            return n + (length >= buffer_chars && (length + element_chars) / element_chars != (hint + element_chars - 1) / element_chars);
+    }
+}
+
+template<class const_string>
+void do_test_allocations()
+{
+    typedef typename const_string::value_type CharT;
+    typedef std::basic_string<CharT> std_string;
+    typedef ::literals<CharT> literals;
+    using boost::lit;
+
+    size_t const buffer_chars(const_string::storage_type::effective_buffer_size_chars);
+    std_string const short_ss(gen_str<CharT>(buffer_chars - 1));
+    std_string const long_ss(gen_str<CharT>(4 * buffer_chars));
+    CharT const* const short_p(short_ss.c_str());
+    CharT const* const long_p(long_ss.c_str());
+
+    { // inline strings, references, literals and copies of those never allocate
+    allocation_count const before(allocation_count::now());
+    {
+        const_string cs01;
+        const_string cs02(short_p);
+        const_string cs03(short_ss);
+        const_string cs04(short_p, short_p + short_ss.size());
+        const_string cs05(buffer_chars - 1, CharT('x'));
+        const_string cs06(boost::cref(literals::some_string));
+        const_string cs07(boost::cref(long_p));
+        const_string cs08(boost::cref(long_ss));
+        const_string cs09(cs02);
+        const_string cs10(cs07);
+        const_string cs11(cs07.ref_substr(1, 2 * buffer_chars));
+        const_string cs12(cs07.substr(1, buffer_chars - 1));
+        const_string cs13(boost::cref(cs07), 1);
+        boost::const_string<CharT> cs14(lit(literals::some_string));
+        BOOST_CHECK(cs14.c_str() == cs14.data());
+        cs01 = cs10;
+        cs10 = cs02;
+        cs02.swap(cs07);
+        cs12.c_str();
+        cs13.c_str();
+    }
+    allocation_count const used(allocation_count::now() - before);
+    BOOST_CHECK_EQUAL(used.new_calls, 0u);
+    BOOST_CHECK_EQUAL(used.allocate_calls, 0u);
+    }
+
+    { // a long string allocates exactly once, its copies share the block
+    allocation_count const before(allocation_count::now());
+    {
+        const_string cs01(long_p);
+        const_string cs02(cs01);
+        const_string cs03;
+        cs03 = cs02;
+        const_string cs04(cs03.ref_substr(1));
+        const_string cs05(boost::cref(cs04));
+        cs03.swap(cs05);
+        cs01.c_str();
+    }
+    allocation_count const used(allocation_count::now() - before);
+    BOOST_CHECK_EQUAL(used.new_calls, 1u);
+    BOOST_CHECK_EQUAL(used.allocate_calls, 1u);
+    BOOST_CHECK_EQUAL(used.deallocate_calls, 1u);
+    }
+
+    { // an immortal string is never freed, neither by its copies made before nor after
+    allocation_count const before(allocation_count::now());
+    {
+        const_string cs01(long_p);
+        const_string cs02(cs01);
+        cs01.make_immortal();
+        const_string cs03(cs01);
+        const_string cs04;
+        cs04 = cs03;
+        cs03 = cs02;
+        cs01.make_immortal();
+        BOOST_CHECK(cs04 == long_ss);
+        BOOST_CHECK(cs04.data() == cs02.data());
+    }
+    allocation_count const used(allocation_count::now() - before);
+    BOOST_CHECK_EQUAL(used.allocate_calls, 1u);
+    BOOST_CHECK_EQUAL(used.deallocate_calls, 0u);
+    }
+
+    { // each constructor that copies a long string allocates exactly once
+    const_string const src(boost::cref(long_ss));
+    allocation_count const before(allocation_count::now());
+    {
+        const_string cs01(long_ss);
+        const_string cs02(long_ss, 1);
+        const_string cs03(long_p, long_ss.size());
+        const_string cs04(long_p, long_p + long_ss.size());
+        const_string cs05(long_ss.begin(), long_ss.end());
+        const_string cs06(long_ss.size(), CharT('x'));
+        const_string cs07(src, 1);
+        const_string cs08(src.substr(1));
+    }
+    allocation_count const used(allocation_count::now() - before);
+    BOOST_CHECK_EQUAL(used.new_calls, 8u);
+    BOOST_CHECK_EQUAL(used.allocate_calls, 8u);
+    BOOST_CHECK_EQUAL(used.deallocate_calls, 8u);
+    }
+
+    { // c_str() of a string that is not zero-terminated copies only a long one
+    const_string const src(long_p);
+    allocation_count const before(allocation_count::now());
+    {
+        const_string cs01(src.ref_substr(0, buffer_chars - 1));
+        cs01.c_str();
+        const_string cs02(src.ref_substr(0, 2 * buffer_chars));
+        cs02.c_str();
+        cs02.c_str();
+    }
+    allocation_count const used(allocation_count::now() - before);
+    BOOST_CHECK_EQUAL(used.allocate_calls, 1u);
+    BOOST_CHECK_EQUAL(used.deallocate_calls, 1u);
+    }
+
+    { // operator+ builds an expression without allocations, materializes it at most once
+    const_string const a(boost::cref(short_p), 1);
+    const_string const b(boost::cref(long_p));
+    allocation_count const before1(allocation_count::now());
+    size_t const size((a + b + short_p + a).size());
+    allocation_count const used1(allocation_count::now() - before1);
+    BOOST_CHECK_EQUAL(size, 2 + short_ss.size() + long_ss.size());
+    BOOST_CHECK_EQUAL(used1.new_calls, 0u);
+
+    allocation_count const before2(allocation_count::now());
+    {
+        const_string const cs01(a + a);
+    }
+    allocation_count const used2(allocation_count::now() - before2);
+    BOOST_CHECK_EQUAL(used2.new_calls, 2 * a.size() < buffer_chars ? 0u : 1u);
+
+    allocation_count const before3(allocation_count::now());
+    {
+        const_string const cs01(a + b + short_p + a);
+    }
+    allocation_count const used3(allocation_count::now() - before3);
+    BOOST_CHECK_EQUAL(used3.new_calls, 1u);
+    BOOST_CHECK_EQUAL(used3.allocate_calls, 1u);
+    }
+
+    { // cs_format() allocates according to its growth policy at each hint boundary
+    size_t const fmt_length(std::char_traits<CharT>::length(literals::fmt2));
+    size_t const element_chars(sizeof(typename boost::cs::aux::aligned_union<boost::detail::atomic_count, CharT>::type) / sizeof(CharT));
+    size_t const length(fmt_length + 4 * 4); // each of four %08x expands to 8 characters
+    for(size_t hint(0); hint <= 2 * length + buffer_chars; ++hint)
+    {
+        allocation_count const before(allocation_count::now());
+        size_t const size(boost::cs_format<const_string>(hint, literals::fmt2, 0, -1, 0x55555555, 0xaaaaaaaa).size());
+        allocation_count const used(allocation_count::now() - before);
+        size_t const expected(expected_format_allocations(buffer_chars, hint ? hint : fmt_length, length, element_chars));
+        BOOST_CHECK_EQUAL(size, length);
+        BOOST_CHECK_EQUAL(used.allocate_calls, expected);
+        BOOST_CHECK_EQUAL(used.deallocate_calls, expected);
+        BOOST_CHECK_EQUAL(used.new_calls, expected);
+    }
+
+    allocation_count const before(allocation_count::now());
+    size_t const size(boost::cs_format<const_string>(buffer_chars - 1, literals::fmt1).size());
+    allocation_count const used(allocation_count::now() - before);
+    BOOST_CHECK_EQUAL(size, std::char_traits<CharT>::length(literals::fmt1));
+    BOOST_CHECK_EQUAL(used.new_calls, expected_format_allocations(buffer_chars, buffer_chars - 1, size, element_chars));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+template class boost::const_string<char>;
+template class boost::const_string<wchar_t>;
+
+template<class CharT>
+struct counting_const_string
+{
+    typedef boost::const_string<
+          CharT
+        , std::char_traits<CharT>
+        , boost::const_string_storage<std::char_traits<CharT>, counting_allocator<CharT> >
+        > type;
+};
+
+// a block shrunk by set_size(), as format() and read_file() do, is freed with the size it was allocated for
+template<class const_string>
+void do_test_set_size()
+{
+    typedef typename const_string::value_type CharT;
+    typedef typename const_string::storage_type storage_type;
+    typedef std::basic_string<CharT> std_string;
+
+    size_t const errors(wrong_size_deallocations);
+    for(size_t n(1); n < 300; n += 1 + n / 3)
+        for(size_t m(0); m <= n; m += 1 + m / 2)
+        {
+            std_string const ss(gen_str<CharT>(n));
+            storage_type stg(0, n);
+            CharT* const p(const_cast<CharT*>(stg.begin()));
+            std::copy(ss.begin(), ss.end(), p);
+            p[m] = CharT();
+            stg.set_size(m);
+            stg.seal();
+            const_string const s(stg);
+            BOOST_CHECK(s == ss.substr(0, m));
+            BOOST_CHECK(!*s.end());
+        }
+    BOOST_CHECK_EQUAL(wrong_size_deallocations, errors);
+}
+
+template<class CharT>
+void do_unit_test()
+{
+    do_test_comparison<boost::const_string<CharT> >();
+    do_test_basic_usage<boost::const_string<CharT> >();
+    do_test_c_str<boost::const_string<CharT> >();
+    do_test_concatenation<boost::const_string<CharT> >();
+    do_test_format<boost::const_string<CharT> >();
+    do_test_io<boost::const_string<CharT> >();
+    do_test_hash<boost::const_string<CharT> >();
+    do_test_allocations<typename counting_const_string<CharT>::type>();
+    do_test_set_size<typename counting_const_string<CharT>::type>();
+    do_test_relocation<boost::const_string<CharT> >();
+    do_test_relocation<typename counting_const_string<CharT>::type>();
+    do_test_sort<typename counting_const_string<CharT>::type>(1000, 1);
+    do_test_sort<typename counting_const_string<CharT>::type>(50000, 4);
+    do_test_table<typename counting_const_string<CharT>::type>();
+    do_test_adopt<typename counting_const_string<CharT>::type>();
+    do_test_dedup<typename counting_const_string<CharT>::type>();
+
+    typedef boost::const_string<
+          CharT
+        , std::char_traits<CharT>
+        , boost::const_string_storage<std::char_traits<CharT>, boost::const_string_pool_allocator<CharT> >
+        > pooled_string;
+    do_test_basic_usage<pooled_string>();
+    do_test_concatenation<pooled_string>();
+    do_test_format<pooled_string>();
+    do_test_relocation<pooled_string>();
+    do_test_pool_allocator<pooled_string>();
+    do_test_set_size<pooled_string>();
+    do_test_atomic<boost::const_string<CharT> >();
+    do_test_intern<boost::const_string<CharT> >();
+    do_test_split<typename counting_const_string<CharT>::type>();
+    do_test_split_lines<typename counting_const_string<CharT>::type>();
+    do_test_parallel_find<boost::const_string<CharT> >();
+    do_test_searcher<boost::const_string<CharT> >();
+    do_test_multi_pattern<boost::const_string<CharT> >();
+    do_test_rope<typename counting_const_string<CharT>::type>();
+    do_test_gather<boost::const_string<CharT> >();
+    do_test_hash_map<boost::const_string<CharT> >();
+    do_test_functional<boost::const_string<CharT> >();
+
+    typedef typename boost::prefix_const_string<CharT>::type prefix_string;
+    do_test_comparison<prefix_string>();
+    do_test_basic_usage<prefix_string>();
+    do_test_c_str<prefix_string>();
+    do_test_concatenation<prefix_string>();
+    do_test_format<prefix_string>();
+    do_test_hash<prefix_string>();
+    do_test_relocation<prefix_string>();
+    do_test_prefix_storage<prefix_string>();
+    do_test_set_size<boost::const_string<CharT, std::char_traits<CharT>,
+        boost::const_string_prefix_storage<std::char_traits<CharT>, counting_allocator<CharT> > > >();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_UNIT_TEST(constant_string_regression_char)
+{
+    std::srand(0);
+    do_unit_test<char>();
+}
+
+#ifndef BOOST_NO_CWCHAR
+
+BOOST_AUTO_UNIT_TEST(constant_string_regression_wchar_t)
+{
+    std::srand(1);
+    do_unit_test<wchar_t>();
+}
+
+#endif // BOOST_NO_CWCHAR
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOST_CONST_STRING_NO_LITERALS
+
+using namespace boost::cs::literals;
+
+// no dynamic initialization for these
+constexpr boost::const_string_literal<char> header_names[] = { "Host"_cs, "Content-Type"_cs, ""_cs };
+static_assert(header_names[1].size() == 12, "size is computed at compile time");
+static_assert(header_names[1].hash() == boost::cs::aux::hash_chars("Content-Type", 12), "hash is computed at compile time");
+static_assert(header_names[1].hash() != header_names[0].hash(), "");
+static_assert(header_names[2].empty(), "");
+
+template<class CharT>
+void do_test_literal(boost::const_string_literal<CharT> const& l)
+{
+    typedef boost::const_string<CharT> const_string;
+    typedef typename counting_const_string<CharT>::type counting_string;
+
+    allocation_count const before(allocation_count::now());
+    const_string const cs1 = l;
+    counting_string const cs2(l);
+    allocation_count const used(allocation_count::now() - before);
+    BOOST_CHECK_EQUAL(used.new_calls, 0u);
+    BOOST_CHECK(cs1.data() == l.data());
+    BOOST_CHECK(cs2.data() == l.data());
+
+    BOOST_CHECK_EQUAL(cs1.size(), l.size());
+    BOOST_CHECK_EQUAL(hash_value(cs1), hash_value(l));
+    BOOST_CHECK_EQUAL(hash_value(cs2), l.hash());
+    BOOST_CHECK(cs1 == l);
+    BOOST_CHECK(l == cs2);
+    BOOST_CHECK(!(cs1 != l));
+    BOOST_CHECK(cs1.ref_substr(0, l.size() - 1) < l);
+    BOOST_CHECK(l > cs2.ref_substr(0, l.size() - 1));
+    BOOST_CHECK(l.str() == cs1);
+
+    boost::const_string_set<const_string> set;
+    set.insert_key(l);
+    BOOST_CHECK(set.contains(cs2));
+    BOOST_CHECK(set.contains(l));
+}
+
+BOOST_AUTO_UNIT_TEST(constant_string_literals)
+{
+    do_test_literal<char>("0123456789abcdefghijklmnopqrstuvwxyz"_cs);
+#ifndef BOOST_NO_CWCHAR
+    do_test_literal<wchar_t>(L"0123456789abcdefghijklmnopqrstuvwxyz"_cs);
+#endif // BOOST_NO_CWCHAR
+}
+
+#endif // BOOST_CONST_STRING_NO_LITERALS
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_UNIT_TEST(constant_string_compact)
+{
+    std::srand(2);
+    typedef boost::compact_const_string<char>::type compact_string;
+    do_test_comparison<compact_string>();
+    do_test_basic_usage<compact_string>();
+    do_test_c_str<compact_string>();
+    do_test_concatenation<compact_string>();
+    do_test_format<compact_string>();
+    do_test_hash<compact_string>();
+    do_test_relocation<compact_string>();
+    do_test_compact_storage<compact_string>();
+    do_test_set_size<boost::const_string<char, std::char_traits<char>,
+        boost::const_string_compact_storage<std::char_traits<char>, counting_allocator<char> > > >();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef BOOST_HAS_UNISTD_H
+
+// a temporary file with the characters, removed by the destructor
+struct temporary_file
+{
+    char path[32];
+
+    explicit temporary_file(std::string const& s)
+    {
+        std::strcpy(path, "/tmp/const_string.XXXXXX");
+        int const fd(::mkstemp(path));
+        BOOST_REQUIRE(fd >= 0);
+        BOOST_REQUIRE(::write(fd, s.data(), s.size()) == static_cast<ssize_t>(s.size()));
+        ::close(fd);
+    }
+
+    ~temporary_file()
+    {
+        ::unlink(path);
+    }
+};
+
+template<class const_string>
+void do_test_read_file()
+{
+    size_t const page(::sysconf(_SC_PAGESIZE));
+    size_t const sizes[] = { 0, 1, 7, 1000, page - 1, page, 3 * page + 5 };
+    for(size_t i(0); i != sizeof sizes / sizeof *sizes; ++i)
+    {
+        std::string const ss(gen_str<char>(sizes[i]));
+        const_string read, mapped;
+        {
+            temporary_file const f(ss);
+            allocation_count const before(allocation_count::now());
+            read = boost::read_file<const_string>(f.path, static_cast<size_t>(-1));
+            // one block at the size of the file at most
+            BOOST_CHECK((allocation_count::now() - before).allocate_calls <= 1u);
+            mapped = boost::read_file<const_string>(f.path, 0);
+        }
+        // the mapping outlives the file
+        BOOST_CHECK(read == ss);
+        BOOST_CHECK(mapped == ss);
+        BOOST_CHECK(mapped.with_c_str(&c_str_length<char>) == ss.size());
+    }
+
+    BOOST_CHECK_THROW(boost::read_file<const_string>("/nonexistent/const_string", 0), std::runtime_error);
+    if(!::access("/proc/self/status", R_OK))
+        BOOST_CHECK(!boost::read_file<const_string>("/proc/self/status", 0).empty()); // no size
+}
+
+BOOST_AUTO_UNIT_TEST(constant_string_read_file)
+{
+    std::srand(3);
+    do_test_read_file<counting_const_string<char>::type>();
+    do_test_read_file<boost::prefix_const_string<char>::type>();
+    do_test_read_file<boost::compact_const_string<char>::type>();
+
+    temporary_file const f(std::string(100, 'a'));
+    BOOST_CHECK(boost::read_file(f.path) == std::string(100, 'a'));
+}
+
+#endif // BOOST_HAS_UNISTD_H
 
 ////////////////////////////////////////////////////////////////////////////////////////////////